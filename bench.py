@@ -5,10 +5,13 @@ import subprocess
 
 from optparse import OptionParser
 
-ALGORITHMS = [ 'globallock'
+ALGORITHMS = [ 'bucket'
+             , 'delegation'
+             , 'globallock'
              , 'heap'
              , 'noble'
              , 'linden'
+             , 'mound'
              , 'spraylist'
              ]
 
@@ -27,13 +30,26 @@ REPS = 10
 
 BIN = 'build/src/pqbench'
 
-def bench(algorithm, ncpus, outfile):
-    output = subprocess.check_output([ BIN
-                                     , '-q', algorithm
-                                     , '-n', str(ncpus)
-                                     ]) # TODO: Size, offset
+def bench(algorithm, ncpus, size, per_core, backlog, offset, outfile):
+    args = [ BIN
+           , '-q', algorithm
+           , '-n', str(ncpus)
+           , '-j', str(per_core)
+           , '-l', str(backlog)
+           ]
 
-    outstr = '%s, %d, %s' % (algorithm, ncpus, output.strip())
+    if offset is not None:
+        args += [ '-o', str(offset) ]
+
+    # Runs across several sizes are told apart by their kernel name.
+    kernel = algorithm
+    if size is not None:
+        args += [ '-s', str(size) ]
+        kernel = '%s-%d' % (algorithm, size)
+
+    output = subprocess.check_output(args)
+
+    outstr = '%s, %d, %s' % (kernel, ncpus, output.strip())
 
     print outstr
     f.write(outstr + '\n')
@@ -46,6 +62,14 @@ if __name__ == '__main__':
             help = "Comma-separated list of cpu counts")
     parser.add_option("-o", "--outfile", dest = "outfile", default = '/dev/null',
             help = "Write results to outfile")
+    parser.add_option("-s", "--sizes", dest = "sizes", default = None,
+            help = "Comma-separated list of initial queue sizes")
+    parser.add_option("-j", "--per-core", dest = "per_core", type = 'int', default = 1,
+            help = "Threads pinned to each core, more than 1 oversubscribes them")
+    parser.add_option("-l", "--backlog", dest = "backlog", type = 'int', default = 0,
+            help = "Per-thread GC backlog limit in blocks, see pqbench -l")
+    parser.add_option("--offset", dest = "offset", type = 'int', default = None,
+            help = "Restructuring offset of linden, see pqbench -o")
     parser.add_option("-r", "--reps", dest = "reps", type = 'int', default = REPS,
             help = "Repetitions per run")
     (options, args) = parser.parse_args()
@@ -62,8 +86,16 @@ if __name__ == '__main__':
         except:
             parser.error('Invalid cpu count')
 
+    sizes = [ None ]
+    if options.sizes is not None:
+        try:
+            sizes = map(int, options.sizes.split(','))
+        except:
+            parser.error('Invalid size')
+
     with open(options.outfile, 'a') as f:
         for a in algorithms:
-            for n in ncpus:
-                for r in xrange(options.reps):
-                    bench(a, n, f)
+            for s in sizes:
+                for n in ncpus:
+                    for r in xrange(options.reps):
+                        bench(a, n, s, options.per_core, options.backlog, options.offset, f)
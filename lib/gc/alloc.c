@@ -0,0 +1,15 @@
+/******************************************************************************
+ * alloc.c
+ *
+ * Node allocator shared by the queues, see alloc.h.
+ */
+
+#include "alloc.h"
+
+const alloc_t *node_allocator = NULL;
+
+void
+set_node_allocator(const alloc_t *a)
+{
+    node_allocator = a;
+}
@@ -0,0 +1,33 @@
+/******************************************************************************
+ * alloc.h
+ *
+ * Allocator of the queues' nodes. By default each queue allocates nodes
+ * its own way: from the epoch GC's pools, from SprayList's slabs, or with
+ * malloc. An allocator installed with set_node_allocator() replaces all of
+ * them, so that queues can be compared on the same allocator.
+ *
+ * Install it before the queues allocate their first node, and do not
+ * change it afterwards: nodes must go back to the allocator they came
+ * from. All functions must be safe to call from any thread, and free must
+ * also take blocks from alloc_aligned.
+ */
+
+#ifndef __ALLOC_H__
+#define __ALLOC_H__
+
+#include <stddef.h>
+
+typedef struct alloc_st
+{
+    void *(*alloc)(size_t size);
+    /* As alloc, aligned to @alignment, a power of two. */
+    void *(*alloc_aligned)(size_t size, size_t alignment);
+    void  (*free)(void *p);
+} alloc_t;
+
+/* The installed allocator, NULL for the queues' own. */
+extern const alloc_t *node_allocator;
+
+void set_node_allocator(const alloc_t *a);
+
+#endif /* __ALLOC_H__ */
@@ -0,0 +1,16 @@
+/******************************************************************************
+ * backoff.c
+ *
+ * Back-off policy shared by the queues, see backoff.h.
+ */
+
+#include "backoff.h"
+
+int backoff_policy = BACKOFF_NONE;
+__thread unsigned int backoff_learned = 0;
+
+void
+backoff_set_policy(int policy)
+{
+    backoff_policy = policy;
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ * backoff.h
+ *
+ * Back-off for the retry loops of the lock-free queues. A failed CAS calls
+ * backoff(), which spins on pause according to the policy selected with
+ * backoff_set_policy(); the operation calls backoff_done() once it has
+ * succeeded.
+ *
+ *  BACKOFF_NONE:        retry immediately (the default).
+ *  BACKOFF_EXPONENTIAL: start at BACKOFF_MIN pauses, double on every
+ *                       collision until BACKOFF_MAX is exceeded, and
+ *                       yield the CPU from then on.
+ *  BACKOFF_ADAPTIVE:    as exponential, but start at the delay the thread
+ *                       has learned from its previous collisions. The
+ *                       delay an operation would have continued with is
+ *                       folded into the learned one, at most BACKOFF_MAX,
+ *                       and every operation which did not collide decays
+ *                       it by an eighth.
+ *
+ * This is the scheme and the bounds of cds::backoff::adaptive.
+ */
+
+#ifndef __BACKOFF_H__
+#define __BACKOFF_H__
+
+#include <sched.h>
+
+enum backoff_policy {
+    BACKOFF_NONE,
+    BACKOFF_EXPONENTIAL,
+    BACKOFF_ADAPTIVE,
+};
+
+/* Pauses of the first and the longest spinning back-off. */
+#define BACKOFF_MIN 4
+#define BACKOFF_MAX 1024
+
+typedef struct backoff_st
+{
+    /* Pauses of the next back-off, 0 before the first collision. */
+    unsigned int delay;
+} backoff_t;
+
+extern int backoff_policy;
+extern __thread unsigned int backoff_learned;
+
+void backoff_set_policy(int policy);
+
+static inline void
+backoff_pause(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__ ("pause" : : : "memory");
+#else
+    __asm__ __volatile__ ("" : : : "memory");
+#endif
+}
+
+static inline void
+backoff_init(backoff_t *b)
+{
+    b->delay = 0;
+}
+
+static inline void
+backoff(backoff_t *b)
+{
+    unsigned int i;
+
+    if (backoff_policy == BACKOFF_NONE)
+        return;
+
+    if (b->delay == 0)
+        b->delay = (backoff_policy == BACKOFF_ADAPTIVE &&
+                    backoff_learned > BACKOFF_MIN) ? backoff_learned : BACKOFF_MIN;
+
+    /* Spinning this long did not help, whoever holds us up may need
+     * our CPU. */
+    if (b->delay > BACKOFF_MAX) {
+        sched_yield();
+        return;
+    }
+
+    for (i = 0; i < b->delay; i++)
+        backoff_pause();
+    b->delay *= 2;
+}
+
+static inline void
+backoff_done(backoff_t *b)
+{
+    if (backoff_policy != BACKOFF_ADAPTIVE)
+        return;
+
+    if (b->delay == 0)
+        backoff_learned -= backoff_learned / 8;
+    else {
+        backoff_learned = (backoff_learned + b->delay) / 2;
+        if (backoff_learned > BACKOFF_MAX)
+            backoff_learned = BACKOFF_MAX;
+    }
+}
+
+#endif /* __BACKOFF_H__ */
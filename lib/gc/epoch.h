@@ -0,0 +1,71 @@
+#ifndef __EPOCH_H
+#define __EPOCH_H
+
+extern "C" {
+#include "gc/gc.h"
+}
+
+/**
+ * C++ interface to the epoch based reclamation in lib/gc, which all
+ * queues share: one set of per-thread state, one epoch and one set of
+ * block pools per process.
+ *
+ * Objects are allocated from and retired to a pool within a critical
+ * region (a guard). A retired object stays valid until every thread has
+ * left the critical regions it was in at the time. Pool memory is raw,
+ * and is reused without running destructors.
+ */
+namespace epoch {
+
+/** Sets up the collector. Calls after the first are no-ops. */
+inline void
+init()
+{
+    _init_gc_subsystem();
+}
+
+/** A critical region, from construction to destruction. */
+class guard
+{
+public:
+    guard() { critical_enter(); }
+    ~guard() { critical_exit(); }
+
+    guard(const guard &) = delete;
+    guard &operator=(const guard &) = delete;
+};
+
+/** Blocks of sizeof(T) bytes, drawn from a size class of the collector. */
+template <typename T>
+class pool
+{
+public:
+    pool() :
+        m_id((init(), gc_add_allocator(sizeof(T))))
+    {
+    }
+
+    T *alloc()
+    {
+        return static_cast<T *>(gc_alloc(ptst, m_id));
+    }
+
+    /** Reuses p once no thread can hold a reference to it anymore. */
+    void retire(T *p)
+    {
+        gc_free(ptst, p, m_id);
+    }
+
+    /** Reuses p right away, for objects never made visible to others. */
+    void release(T *p)
+    {
+        gc_unsafe_free(ptst, p, m_id);
+    }
+
+private:
+    const int m_id;
+};
+
+}
+
+#endif /* __EPOCH_H */
@@ -0,0 +1,1304 @@
+/******************************************************************************
+ * gc.c
+ * 
+ * A fully recycling epoch-based garbage collector. Works by counting
+ * threads in and out of critical regions, to work out when
+ * garbage queues can be fully deleted.
+ * 
+ * Copyright (c) 2001-2003, K A Fraser
+ * 
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * * The name of the author may not be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR 
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, 
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE /* MAP_HUGETLB, MADV_HUGEPAGE, syscall */
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "portable_defns.h"
+#include "alloc.h"
+#include "gc.h"
+
+/*#define MINIMAL_GC*/
+/*#define YIELD_TO_HELP_PROGRESS*/
+//#define PROFILE_GC
+
+/* Recycled nodes are filled with this value if WEAK_MEM_ORDER. */
+#define INVALID_BYTE 0
+#define INITIALISE_NODES(_p,_c) memset((_p), INVALID_BYTE, (_c));
+
+/* Number of unique block sizes we can deal with. Linden alone registers
+ * one per skiplist level (32), leave room for other users. */
+#define MAX_SIZES GC_MAX_SIZES
+
+#define MAX_HOOKS GC_MAX_HOOKS
+
+/*
+ * NUMA nodes which get their own pools. Threads on further nodes share
+ * the pools of node (their node % MAX_NUMA_NODES).
+ */
+#define MAX_NUMA_NODES 8
+
+/*
+ * With NUMA pools, blocks are carved out of per-node arenas of
+ * ARENA_SIZE bytes, backed by huge pages and bound to the node.
+ */
+#define HUGE_PAGE_SIZE (2UL << 20)
+#define ARENA_SIZE     (16 * HUGE_PAGE_SIZE)
+
+/*
+ * Arenas backed by explicit huge pages, which trimming must release
+ * whole. Further arenas use transparent huge pages instead.
+ */
+#define MAX_HUGETLB_MAPS 64
+
+/*
+ * Free memory in the main allocation lists above which the reclaimer
+ * returns free pages to the OS, see gc_set_trim_watermark().
+ */
+#define DEFAULT_TRIM_WATERMARK (64UL << 20)
+
+/*
+ * The initial number of allocation chunks for each per-blocksize list.
+ * Popular allocation lists will steadily increase the allocation unit
+ * in line with demand.
+ */
+#define ALLOC_CHUNKS_PER_LIST 10
+
+/*
+ * How many times should a thread call gc_enter(), seeing the same epoch
+ * each time, before it makes a reclaim attempt?
+ */
+#define ENTRIES_PER_RECLAIM_ATTEMPT 100
+
+/*
+ *  0: current epoch -- threads are moving to this;
+ * -1: some threads may still throw garbage into this epoch;
+ * -2: no threads can see this epoch => we can zero garbage lists;
+ * -3: all threads see zeros in these garbage lists => move to alloc lists.
+ */
+#ifdef WEAK_MEM_ORDER
+#define NR_EPOCHS 4
+#else
+#define NR_EPOCHS 3
+#endif
+
+/*
+ * A chunk amortises the cost of allocation from shared lists. It also
+ * helps when zeroing nodes, as it increases per-cacheline pointer density
+ * and means that node locations don't need to be brought into the cache 
+ * (most architectures have a non-temporal store instruction).
+ */
+#define BLKS_PER_CHUNK 100
+typedef struct chunk_st chunk_t;
+struct chunk_st
+{
+    chunk_t *next;             /* chunk chaining                 */
+    unsigned int i;            /* the next entry in blk[] to use */
+    void *blk[BLKS_PER_CHUNK];
+};
+
+/* Bump allocator for the blocks of one NUMA node. */
+typedef struct
+{
+    VOLATILE unsigned int lock;
+    char *next;
+    char *end;
+} arena_t;
+
+/* An address range [start,end). */
+typedef struct
+{
+    char *start;
+    char *end;
+} range_t;
+
+static struct gc_global_st
+{
+    CACHE_PAD(0);
+
+    /* The current epoch. */
+    VOLATILE unsigned int current;
+    /* Number of epoch advances so far, never wraps in practice. */
+    VOLATILE unsigned long epochs;
+    CACHE_PAD(1);
+
+    /* Exclusive access to gc_reclaim(). */
+    VOLATILE unsigned int inreclaim;
+    CACHE_PAD(2);
+
+    /*
+     * RUN-TIME CONSTANTS (to first approximation)
+     */
+
+    /* Memory page size, in bytes. */
+    unsigned int page_size;
+
+    /* Node sizes (run-time constants). */
+    int nr_sizes;
+    int blk_sizes[MAX_SIZES];
+
+    /* Registered epoch hooks. */
+    int nr_hooks;
+    hook_fn_t hook_fns[MAX_HOOKS];
+    CACHE_PAD(3);
+
+    /*
+     * DATA WE MAY HIT HARD
+     */
+
+    /* Chain of free, empty chunks. */
+    chunk_t * VOLATILE free_chunks;
+
+    /* Main allocation lists, per NUMA node. Lists of nodes other than 0
+     * are only created once a thread on that node needs them. */
+    chunk_t * VOLATILE alloc[MAX_NUMA_NODES][MAX_SIZES];
+    VOLATILE unsigned int alloc_size[MAX_NUMA_NODES][MAX_SIZES];
+
+    /* Full chunks ever added to each main allocation list. Chunks taken
+     * are counted per thread, see free_bytes(). */
+    VOLATILE unsigned long nr_added[MAX_NUMA_NODES][MAX_SIZES];
+
+    /* Whether threads get pools on their own NUMA node. */
+    int numa;
+    arena_t arena[MAX_NUMA_NODES];
+
+    /* Arenas mapped with MAP_HUGETLB, see release_pages(). */
+    VOLATILE int nr_hugetlb;
+    range_t hugetlb[MAX_HUGETLB_MAPS];
+
+    /*
+     * Trimming state, owned by the reclaimer. The lock serialises refilling
+     * the main allocation lists with trimming them.
+     */
+    VOLATILE unsigned int trim_lock;
+    size_t trim_watermark;
+    size_t trim_at;
+    size_t trimmed;
+
+    /* Garbage per thread above which a stalled epoch throttles it. */
+    unsigned long backlog_limit;
+#ifdef PROFILE_GC
+    VOLATILE unsigned int total_size;
+    VOLATILE unsigned int allocations;
+#endif
+} gc_global;
+
+
+/* Per-thread state. */
+struct gc_st
+{
+    /* NUMA node whose pools this thread allocates from and frees to. */
+    int node;
+
+    /* Epoch that this thread sees. */
+    unsigned int epoch;
+
+    /* Number of calls to gc_entry() since last gc_reclaim() attempt. */
+    unsigned int entries_since_reclaim;
+
+#ifdef YIELD_TO_HELP_PROGRESS
+    /* Number of calls to gc_reclaim() since we last yielded. */
+    unsigned int reclaim_attempts_since_yield;
+#endif
+
+    /* Used by gc_async_barrier(). */
+    void *async_page;
+    int   async_page_state;
+
+    /* Garbage lists. */
+    chunk_t *garbage[NR_EPOCHS][MAX_SIZES];
+    chunk_t *garbage_tail[NR_EPOCHS][MAX_SIZES];
+    chunk_t *chunk_cache;
+
+    /* Local allocation lists. */
+    chunk_t *alloc[MAX_SIZES];
+    unsigned int alloc_chunks[MAX_SIZES];
+
+    /* Chunks taken from the main allocation lists, see free_bytes(). */
+    VOLATILE unsigned long nr_taken[MAX_SIZES];
+
+    /* Hook pointer lists. */
+    chunk_t *hook[NR_EPOCHS][MAX_HOOKS];
+
+    /*
+     * Statistics, see gc_get_stats(). Each counter has a single writer:
+     * recycled[] and hooks_run[] are only written by whoever reclaims our
+     * garbage, under the reclaim lock, and all others only by us. Blocks freed with
+     * gc_unsafe_free() are recycled at once, and counted apart.
+     */
+    unsigned long epochs, reclaims, reclaim_stalls, reclaim_busy;
+    unsigned long throttles, peak_backlog;
+    unsigned long allocated[MAX_SIZES];
+    unsigned long freed[MAX_SIZES];
+    VOLATILE unsigned long recycled[MAX_SIZES];
+    unsigned long unsafe_freed[MAX_SIZES];
+    unsigned long hooks_queued[MAX_HOOKS];
+    VOLATILE unsigned long hooks_run[MAX_HOOKS];
+};
+
+
+#define MEM_FAIL(_s)                                                         \
+do {                                                                         \
+    fprintf(stderr, "OUT OF MEMORY: %d bytes at line %d\n", (_s), __LINE__); \
+    exit(1);                                                                 \
+} while ( 0 )
+
+
+/* Allocate more empty chunks from the heap. */
+#define CHUNKS_PER_ALLOC 1000
+static chunk_t *alloc_more_chunks(void)
+{
+    int i;
+    chunk_t *h, *p;
+
+    h = p = ALIGNED_ALLOC(CHUNKS_PER_ALLOC * sizeof(*h));
+    if ( h == NULL ) MEM_FAIL(CHUNKS_PER_ALLOC * sizeof(*h));
+
+    for ( i = 1; i < CHUNKS_PER_ALLOC; i++ )
+    {
+        p->next = p + 1;
+        p++;
+    }
+
+    p->next = h;
+
+    return(h);
+}
+
+
+/* Put a chain of chunks onto a list. */
+static void add_chunks_to_list(chunk_t *ch, chunk_t *head)
+{
+    chunk_t *h_next, *new_h_next, *ch_next;
+    ch_next    = ch->next;
+    new_h_next = head->next;
+    do { ch->next = h_next = new_h_next; WMB_NEAR_CAS(); }
+    while ( (new_h_next = CASPO(&head->next, h_next, ch_next)) != h_next );
+}
+
+
+/* Allocate a chain of @n empty chunks. Pointers may be garbage. */
+static chunk_t *get_empty_chunks(int n)
+{
+    int i;
+    chunk_t *new_rh, *rh, *rt, *head;
+
+ retry:
+    head = gc_global.free_chunks;
+    new_rh = head->next;
+    do {
+        rh = new_rh;
+        rt = head;
+        WEAK_DEP_ORDER_RMB();
+        for ( i = 0; i < n; i++ )
+        {
+            if ( (rt = rt->next) == head )
+            {
+                /* Allocate some more chunks. */
+                add_chunks_to_list(alloc_more_chunks(), head);
+                goto retry;
+            }
+        }
+    }
+    while ( (new_rh = CASPO(&head->next, rh, rt->next)) != rh );
+
+    rt->next = rh;
+    return(rh);
+}
+
+
+/* The NUMA node the calling thread runs on. */
+static int current_numa_node(void)
+{
+    unsigned int cpu, node;
+    if ( syscall(SYS_getcpu, &cpu, &node, NULL) != 0 ) return 0;
+    return (int)(node % MAX_NUMA_NODES);
+}
+
+
+/* Record [@p,@p+@len) as backed by explicit huge pages, if there is room. */
+static int add_hugetlb(char *p, size_t len)
+{
+    int i = gc_global.nr_hugetlb, ni;
+
+    for ( ; ; i = ni )
+    {
+        if ( i >= MAX_HUGETLB_MAPS ) return 0;
+        if ( (ni = CASIO(&gc_global.nr_hugetlb, i, i+1)) == i ) break;
+    }
+
+    /* Until written, the zeroed entry overlaps nothing. No block of the
+     * range is in a list yet, so trimming cannot miss it. */
+    gc_global.hugetlb[i].start = p;
+    gc_global.hugetlb[i].end   = p + len;
+    WMB();
+    return 1;
+}
+
+
+/* Whether [@start,@end) overlaps an arena of explicit huge pages. */
+static int overlaps_hugetlb(char *start, char *end)
+{
+    int i, n = gc_global.nr_hugetlb;
+
+    for ( i = 0; i < n; i++ )
+        if ( (start < gc_global.hugetlb[i].end) &&
+             (gc_global.hugetlb[i].start < end) )
+            return 1;
+    return 0;
+}
+
+
+/*
+ * Map @len bytes, a multiple of HUGE_PAGE_SIZE, preferably placed on NUMA
+ * node @node. Explicit huge pages are used if the system has reserved
+ * some and there is room to record them, and transparent huge pages
+ * otherwise.
+ */
+static char *map_huge(size_t len, int node)
+{
+    unsigned long mask = 1UL << node;
+    char *p = MAP_FAILED;
+
+    if ( gc_global.nr_hugetlb < MAX_HUGETLB_MAPS )
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if ( (p != MAP_FAILED) && !add_hugetlb(p, len) )
+    {
+        munmap(p, len);
+        p = MAP_FAILED;
+    }
+    if ( p == MAP_FAILED )
+    {
+        /* Align to huge pages, the slack is not worth unmapping. */
+        p = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ( p == MAP_FAILED ) return NULL;
+        p = (char *)(((unsigned long)p + HUGE_PAGE_SIZE - 1) &
+                     ~(HUGE_PAGE_SIZE - 1));
+        (void)madvise(p, len, MADV_HUGEPAGE);
+    }
+
+    /* Nothing has been touched yet, so all pages will honour this. A
+     * preference rather than a binding, a full node must not OOM us. */
+    (void)syscall(SYS_mbind, p, len, MPOL_PREFERRED, &mask,
+                  MAX_NUMA_NODES + 1, 0);
+
+    return p;
+}
+
+
+/* Allocate @sz bytes, cache line aligned, from the arena of @node. */
+static char *arena_alloc(int node, size_t sz)
+{
+    arena_t *a = &gc_global.arena[node];
+    size_t len;
+    char *p;
+
+    sz = (sz + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+
+    while ( a->lock || CASIO(&a->lock, 0, 1) ) ;
+
+    if ( (size_t)(a->end - a->next) < sz )
+    {
+        len = (sz + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if ( len < ARENA_SIZE ) len = ARENA_SIZE;
+        if ( (p = map_huge(len, node)) == NULL )
+        {
+            a->lock = 0;
+            return NULL;
+        }
+        a->next = p;
+        a->end  = p + len;
+    }
+
+    p = a->next;
+    a->next += sz;
+
+    WMB();
+    a->lock = 0;
+
+    return p;
+}
+
+
+/*
+ * Get @n filled chunks, pointing at blocks of @sz bytes each, placed on
+ * NUMA node @numa_node if NUMA pools are enabled.
+ */
+static chunk_t *get_filled_chunks(int n, int sz, int numa_node)
+{
+    chunk_t *h, *p;
+    char *node;
+    int i;
+
+#ifdef PROFILE_GC
+    ADD_TO(gc_global.total_size, n * BLKS_PER_CHUNK * sz);
+    ADD_TO(gc_global.allocations, 1);
+#endif
+
+    node = gc_global.numa ? arena_alloc(numa_node, n * BLKS_PER_CHUNK * sz)
+        : ALIGNED_ALLOC(n * BLKS_PER_CHUNK * sz);
+    if ( node == NULL ) MEM_FAIL(n * BLKS_PER_CHUNK * sz);
+#ifdef WEAK_MEM_ORDER
+    INITIALISE_NODES(node, n * BLKS_PER_CHUNK * sz);
+#endif
+
+    h = p = get_empty_chunks(n);
+    do {
+        p->i = BLKS_PER_CHUNK;
+        for ( i = 0; i < BLKS_PER_CHUNK; i++ )
+        {
+            p->blk[i] = node;
+            node += sz;
+        }
+    }
+    while ( (p = p->next) != h );
+
+    return(h);
+}
+
+
+/*
+ * gc_async_barrier: Cause an asynchronous barrier in all other threads. We do 
+ * this by causing a TLB shootdown to be propagated to all other processors. 
+ * Each time such an action is required, this function calls:
+ *   mprotect(async_page, <page size>, <new flags>)
+ * Each thread's state contains a memory page dedicated for this purpose.
+ */
+#ifdef WEAK_MEM_ORDER
+static void gc_async_barrier(gc_t *gc)
+{
+    mprotect(gc->async_page, gc_global.page_size,
+             gc->async_page_state ? PROT_READ : PROT_NONE);
+    gc->async_page_state = !gc->async_page_state;
+}
+#else
+#define gc_async_barrier(_g) ((void)0)
+#endif
+
+
+/* The main level @i allocation chain of NUMA node @node. */
+static chunk_t *get_alloc_list(int node, int i)
+{
+    chunk_t *alloc = gc_global.alloc[node][i], *h;
+
+    if ( alloc == NULL )
+    {
+        /* An empty list is a lone chunk pointing at itself. */
+        h = get_empty_chunks(1);
+        h->i = 0;
+        gc_global.alloc_size[node][i] = ALLOC_CHUNKS_PER_LIST;
+        if ( (alloc = CASPO(&gc_global.alloc[node][i], NULL, h)) == NULL )
+            alloc = h;
+        else
+            add_chunks_to_list(h, gc_global.free_chunks);
+    }
+
+    return alloc;
+}
+
+
+static void lock_trim(void)
+{
+    while ( gc_global.trim_lock || CASIO(&gc_global.trim_lock, 0, 1) ) ;
+}
+
+
+static void unlock_trim(void)
+{
+    WMB();
+    gc_global.trim_lock = 0;
+}
+
+
+/* Grab a level @i allocation chunk from main chain. */
+static chunk_t *get_alloc_chunk(gc_t *gc, int i)
+{
+    chunk_t *alloc, *p, *new_p, *nh;
+    unsigned int sz;
+
+    alloc = get_alloc_list(gc->node, i);
+    new_p = alloc->next;
+
+    do {
+        p = new_p;
+        while ( p == alloc )
+        {
+            /* The list may just be detached for trimming, see trim_size(). */
+            lock_trim();
+            if ( (p = alloc->next) == alloc )
+            {
+                sz = gc_global.alloc_size[gc->node][i];
+                nh = get_filled_chunks(sz, gc_global.blk_sizes[i], gc->node);
+                ADD_TO(gc_global.alloc_size[gc->node][i], sz >> 3);
+                gc_async_barrier(gc);
+                add_chunks_to_list(nh, alloc);
+                ADD_TO(gc_global.nr_added[gc->node][i], sz);
+                p = alloc->next;
+            }
+            unlock_trim();
+        }
+        WEAK_DEP_ORDER_RMB();
+    }
+    while ( (new_p = CASPO(&alloc->next, p, p->next)) != p );
+
+    gc->nr_taken[i]++;
+    p->next = p;
+    assert(p->i == BLKS_PER_CHUNK);
+    return(p);
+}
+
+
+/* Order block addresses. */
+static int blk_cmp(const void *a, const void *b)
+{
+    char *pa = *(char * const *)a, *pb = *(char * const *)b;
+    return (pa > pb) - (pa < pb);
+}
+
+
+/*
+ * Release the pages within [@start,@end). Explicit huge pages can only be
+ * released whole, so ranges overlapping them are released in units of
+ * HUGE_PAGE_SIZE (which older kernels refuse as well). Returns the bytes
+ * released.
+ */
+static size_t release_pages(char *start, char *end)
+{
+    unsigned long ps = gc_global.page_size, us = ps, s, e, p;
+    unsigned char vec[512];
+    size_t resident, released = 0;
+    int j, n, per_unit;
+
+    if ( overlaps_hugetlb(start, end) ) us = HUGE_PAGE_SIZE;
+    per_unit = us / ps;
+
+    s = ((unsigned long)start + us - 1) & ~(us - 1);
+    e = (unsigned long)end & ~(us - 1);
+
+    for ( p = s; p < e; p += n * us )
+    {
+        n = sizeof(vec) / per_unit;
+        if ( (e - p) / us < (unsigned long)n ) n = (e - p) / us;
+        /* Only count pages which are actually resident, once released. */
+        if ( mincore((void *)p, n * us, vec) != 0 ) return released;
+        for ( resident = 0, j = 0; j < n * per_unit; j++ )
+            if ( vec[j] & 1 ) resident += ps;
+        if ( madvise((void *)p, n * us, MADV_DONTNEED) != 0 ) return released;
+        released += resident;
+    }
+
+    return released;
+}
+
+
+/*
+ * Return the pages of size class @i which lie entirely within free blocks
+ * to the OS. Blocks of a fill are adjacent, so this finds runs of adjacent
+ * free blocks. Released blocks stay in their lists, and read as zero once
+ * touched again. The lists are detached meanwhile, threads which find
+ * them empty wait on the trim lock. Returns the number of bytes released.
+ */
+static size_t trim_size(int i)
+{
+    chunk_t *alloc, *first[MAX_NUMA_NODES], *last[MAX_NUMA_NODES], *p;
+    char **blks, *run_start;
+    int n, j, k, nr_chunks = 0, nr_blks = 0, sz = gc_global.blk_sizes[i];
+    size_t released = 0;
+
+    lock_trim();
+
+    /* Nothing is added while we hold the lock, the chains end at alloc. */
+    for ( n = 0; n < MAX_NUMA_NODES; n++ )
+    {
+        first[n] = NULL;
+        if ( (alloc = gc_global.alloc[n][i]) == NULL ) continue;
+        do {
+            if ( (p = alloc->next) == alloc ) break;
+        }
+        while ( CASPO(&alloc->next, p, alloc) != p );
+        if ( p == alloc ) continue;
+        first[n] = p;
+        for ( ; p != alloc; p = p->next ) last[n] = p, nr_chunks++;
+    }
+    if ( nr_chunks == 0 ) goto out;
+
+    if ( (blks = malloc(nr_chunks * BLKS_PER_CHUNK * sizeof(*blks))) == NULL )
+        goto restore;
+
+    for ( n = 0; n < MAX_NUMA_NODES; n++ )
+    {
+        if ( first[n] == NULL ) continue;
+        for ( p = first[n]; ; p = p->next )
+        {
+            for ( k = 0; k < BLKS_PER_CHUNK; k++ ) blks[nr_blks++] = p->blk[k];
+            if ( p == last[n] ) break;
+        }
+    }
+    qsort(blks, nr_blks, sizeof(*blks), blk_cmp);
+
+    for ( j = 1, run_start = blks[0]; j <= nr_blks; j++ )
+    {
+        if ( (j < nr_blks) && (blks[j] == blks[j-1] + sz) ) continue;
+        released += release_pages(run_start, blks[j-1] + sz);
+        if ( j < nr_blks ) run_start = blks[j];
+    }
+
+    free(blks);
+
+ restore:
+    for ( n = 0; n < MAX_NUMA_NODES; n++ )
+    {
+        if ( first[n] == NULL ) continue;
+        last[n]->next = first[n];
+        add_chunks_to_list(last[n], gc_global.alloc[n][i]);
+    }
+
+ out:
+    unlock_trim();
+    return released;
+}
+
+
+/* Trim all size classes. */
+static size_t trim_all(void)
+{
+    size_t released = 0;
+    int i;
+
+    for ( i = 0; i < gc_global.nr_sizes; i++ )
+        released += trim_size(i);
+
+    gc_global.trimmed += released;
+    return released;
+}
+
+
+/*
+ * Free memory in the main allocation lists: the chunks added to them less
+ * those taken, which threads count on their own to keep the allocation
+ * path free of shared writes. Counts are read racily.
+ */
+static size_t free_bytes(void)
+{
+    unsigned long added, taken;
+    size_t bytes = 0;
+    ptst_t *ptst;
+    int n, i;
+
+    for ( i = 0; i < gc_global.nr_sizes; i++ )
+    {
+        added = taken = 0;
+        for ( n = 0; n < MAX_NUMA_NODES; n++ )
+            added += gc_global.nr_added[n][i];
+        for ( ptst = ptst_first(); ptst != NULL; ptst = ptst_next(ptst) )
+            taken += ptst->gc->nr_taken[i];
+        if ( added > taken )
+            bytes += (size_t)(added - taken) * BLKS_PER_CHUNK *
+                gc_global.blk_sizes[i];
+    }
+
+    return bytes;
+}
+
+
+/*
+ * Trim once free memory exceeds the watermark. Released blocks still
+ * count as free, so the next attempt waits until free memory has doubled.
+ */
+static void maybe_trim(void)
+{
+    size_t bytes;
+
+    if ( gc_global.trim_watermark == 0 ) return;
+
+    bytes = free_bytes();
+    if ( bytes < gc_global.trim_watermark )
+    {
+        gc_global.trim_at = gc_global.trim_watermark;
+        return;
+    }
+    if ( bytes < gc_global.trim_at ) return;
+
+    trim_all();
+    gc_global.trim_at = 2 * bytes;
+}
+
+
+#ifndef MINIMAL_GC
+/*
+ * gc_reclaim: Scans the list of struct gc_perthread looking for the lowest
+ * maximum epoch number seen by a thread that's in the list code. If it's the
+ * current epoch, the "nearly-free" lists from the previous epoch are 
+ * reclaimed, and the epoch is incremented.
+ */
+static int gc_reclaim(ptst_t * our_ptst)
+{
+    ptst_t       *ptst, *first_ptst; //, *our_ptst = NULL;
+    gc_t         *gc = NULL;
+    unsigned long curr_epoch;
+    chunk_t      *ch, *t;
+    int           two_ago, three_ago, i, j;
+
+    our_ptst->gc->reclaims++;
+
+    /* Barrier to entering the reclaim critical section. */
+    if ( gc_global.inreclaim || CASIO(&gc_global.inreclaim, 0, 1) )
+    {
+        our_ptst->gc->reclaim_busy++;
+        return 0;
+    }
+
+    /*
+     * Grab first ptst structure *before* barrier -- prevent bugs
+     * on weak-ordered architectures.
+     */
+    first_ptst = ptst_first();
+    MB();
+    curr_epoch = gc_global.current;
+
+    /* Have all threads seen the current epoch, or not in mutator code? */
+    for ( ptst = first_ptst; ptst != NULL; ptst = ptst_next(ptst) )
+    {
+        if ( (ptst->count > 1) && (ptst->gc->epoch != curr_epoch) )
+        {
+            our_ptst->gc->reclaim_stalls++;
+            goto out;
+        }
+    }
+
+    /*
+     * Three-epoch-old garbage lists move to allocation lists.
+     * Two-epoch-old garbage lists are cleaned out.
+     */
+    two_ago   = (curr_epoch+2) % NR_EPOCHS;
+    three_ago = (curr_epoch+1) % NR_EPOCHS;
+    //if ( gc_global.nr_hooks != 0 )
+        //our_ptst = (ptst_t *)pthread_getspecific(ptst_key);
+    for ( ptst = first_ptst; ptst != NULL; ptst = ptst_next(ptst) )
+    {
+        gc = ptst->gc;
+
+        for ( i = 0; i < gc_global.nr_sizes; i++ )
+        {
+            /* NB. Leave one chunk behind, as it is probably not yet full. */
+            t = gc->garbage[three_ago][i];
+            if ( (t == NULL) || ((ch = t->next) == t) ) continue;
+            gc->garbage_tail[three_ago][i]->next = ch;
+            gc->garbage_tail[three_ago][i] = t;
+            t->next = t;
+            for ( j = 1, t = ch->next; t != ch; t = t->next ) j++;
+            if ( node_allocator != NULL )
+            {
+                /* Blocks go back to the node allocator they came from. */
+                do { while ( t->i > 0 ) node_allocator->free(t->blk[--t->i]); }
+                while ( (t = t->next) != ch );
+                add_chunks_to_list(ch, gc_global.free_chunks);
+            }
+            else
+            {
+                /* Recycled blocks stay on the node of the freeing thread. */
+                add_chunks_to_list(ch, get_alloc_list(gc->node, i));
+                ADD_TO(gc_global.nr_added[gc->node][i], j);
+            }
+            gc->recycled[i] += j * BLKS_PER_CHUNK;
+        }
+
+        for ( i = 0; i < gc_global.nr_hooks; i++ )
+        {
+            hook_fn_t fn = gc_global.hook_fns[i];
+            ch = gc->hook[three_ago][i];
+            if ( ch == NULL ) continue;
+            gc->hook[three_ago][i] = NULL;
+
+            t = ch;
+            do {
+                for ( j = 0; j < t->i; j++ ) fn(our_ptst, t->blk[j]);
+                gc->hooks_run[i] += t->i;
+            }
+            while ( (t = t->next) != ch );
+
+            add_chunks_to_list(ch, gc_global.free_chunks);
+        }
+    }
+
+    /* Update current epoch. The count goes first, so that a reader who
+     * sees an unchanged count has not missed an advance. */
+    gc_global.epochs++;
+    WMB();
+    gc_global.current = (curr_epoch+1) % NR_EPOCHS;
+    our_ptst->gc->epochs++;
+
+    maybe_trim();
+    gc_global.inreclaim = 0;
+    return 1;
+
+ out:
+    gc_global.inreclaim = 0;
+    return 0;
+}
+
+
+/* Blocks freed by @gc which have not been recycled yet. */
+static unsigned long garbage_backlog(gc_t *gc)
+{
+    unsigned long backlog = 0;
+    int i;
+
+    for ( i = 0; i < gc_global.nr_sizes; i++ )
+        backlog += gc->freed[i] - gc->recycled[i];
+
+    if ( backlog > gc->peak_backlog ) gc->peak_backlog = backlog;
+    return backlog;
+}
+
+
+/*
+ * Called after a failed epoch advance, outside of critical regions. A
+ * thread in a critical region which has been descheduled holds up the
+ * epoch, and garbage piles up meanwhile. Epoch based reclamation cannot
+ * free anything such a thread may still reach, so bound memory by making
+ * threads with too much garbage give up their CPU until the epoch moves.
+ */
+static void gc_throttle(ptst_t *ptst)
+{
+    gc_t *gc = ptst->gc;
+    unsigned long backlog = garbage_backlog(gc);
+
+    if ( gc_global.backlog_limit == 0 ) return;
+
+    while ( backlog > gc_global.backlog_limit &&
+            !gc_reclaim(ptst) )
+    {
+        gc->throttles++;
+        sched_yield();
+        backlog = garbage_backlog(gc);
+    }
+}
+#endif /* MINIMAL_GC */
+
+
+/*
+ * Alignment of the blocks of size class @alloc_id. Pools carve blocks out
+ * of cache line aligned fills, so a block is aligned to the largest power
+ * of two dividing its size, up to a cache line. Blocks from the node
+ * allocator keep that guarantee.
+ */
+static size_t blk_alignment(int alloc_id)
+{
+    size_t sz = gc_global.blk_sizes[alloc_id], align = sz & -sz;
+    return (align < CACHE_LINE_SIZE) ? align : CACHE_LINE_SIZE;
+}
+
+
+void *gc_alloc(ptst_t *ptst, int alloc_id)
+{
+    gc_t *gc = ptst->gc;
+    chunk_t *ch;
+
+    if ( node_allocator != NULL )
+    {
+        gc->allocated[alloc_id]++;
+        return node_allocator->alloc_aligned(gc_global.blk_sizes[alloc_id],
+                                             blk_alignment(alloc_id));
+    }
+
+    ch = gc->alloc[alloc_id];
+    if ( ch->i == 0 )
+    {
+        if ( gc->alloc_chunks[alloc_id]++ == 100 )
+        {
+            gc->alloc_chunks[alloc_id] = 0;
+            add_chunks_to_list(ch, gc_global.free_chunks);
+            gc->alloc[alloc_id] = ch = get_alloc_chunk(gc, alloc_id);
+        }
+        else
+        {
+            chunk_t *och = ch;
+            ch = get_alloc_chunk(gc, alloc_id);
+            ch->next  = och->next;
+            och->next = ch;
+            gc->alloc[alloc_id] = ch;        
+        }
+    }
+
+    gc->allocated[alloc_id]++;
+    return ch->blk[--ch->i];
+}
+
+
+static chunk_t *chunk_from_cache(gc_t *gc)
+{
+    chunk_t *ch = gc->chunk_cache, *p = ch->next;
+
+    if ( ch == p )
+    {
+        gc->chunk_cache = get_empty_chunks(100);
+    }
+    else
+    {
+        ch->next = p->next;
+        p->next  = p;
+    }
+
+    p->i = 0;
+    return(p);
+}
+
+
+void gc_free(ptst_t *ptst, void *p, int alloc_id) 
+{
+#ifndef MINIMAL_GC
+    gc_t *gc = ptst->gc;
+    chunk_t *prev, *new, *ch = gc->garbage[gc->epoch][alloc_id];
+
+    if ( ch == NULL )
+    {
+        gc->garbage[gc->epoch][alloc_id] = ch = chunk_from_cache(gc);
+        gc->garbage_tail[gc->epoch][alloc_id] = ch;
+    }
+    else if ( ch->i == BLKS_PER_CHUNK )
+    {
+        prev = gc->garbage_tail[gc->epoch][alloc_id];
+        new  = chunk_from_cache(gc);
+        gc->garbage[gc->epoch][alloc_id] = new;
+        new->next  = ch;
+        prev->next = new;
+        ch = new;
+    }
+
+    ch->blk[ch->i++] = p;
+    gc->freed[alloc_id]++;
+#endif
+}
+
+
+void gc_add_ptr_to_hook_list(ptst_t *ptst, void *ptr, int hook_id)
+{
+    gc_t *gc = ptst->gc;
+    chunk_t *och, *ch = gc->hook[gc->epoch][hook_id];
+
+    if ( ch == NULL )
+    {
+        gc->hook[gc->epoch][hook_id] = ch = chunk_from_cache(gc);
+    }
+    else
+    {
+        ch = ch->next;
+        if ( ch->i == BLKS_PER_CHUNK )
+        {
+            och       = gc->hook[gc->epoch][hook_id];
+            ch        = chunk_from_cache(gc);
+            ch->next  = och->next;
+            och->next = ch;
+        }
+    }
+
+    ch->blk[ch->i++] = ptr;
+    gc->hooks_queued[hook_id]++;
+}
+
+
+void gc_unsafe_free(ptst_t *ptst, void *p, int alloc_id)
+{
+    gc_t *gc = ptst->gc;
+    chunk_t *ch;
+
+    if ( node_allocator != NULL )
+    {
+        gc->unsafe_freed[alloc_id]++;
+        node_allocator->free(p);
+        return;
+    }
+
+    ch = gc->alloc[alloc_id];
+    if ( ch->i < BLKS_PER_CHUNK )
+    {
+        ch->blk[ch->i++] = p;
+        gc->unsafe_freed[alloc_id]++;
+    }
+    else
+    {
+        gc_free(ptst, p, alloc_id);
+    }
+}
+
+
+void gc_enter(ptst_t *ptst)
+{
+#ifdef MINIMAL_GC
+    ptst->count++;
+    MB();
+#else
+    gc_t *gc = ptst->gc;
+    int new_epoch, cnt;
+ 
+ retry:
+    cnt = ptst->count++;
+    MB();
+    if ( cnt == 1 )
+    {
+        new_epoch = gc_global.current;
+        if ( gc->epoch != new_epoch )
+        {
+            gc->epoch = new_epoch;
+            gc->entries_since_reclaim        = 0;
+#ifdef YIELD_TO_HELP_PROGRESS
+            gc->reclaim_attempts_since_yield = 0;
+#endif
+        }
+        else if ( gc->entries_since_reclaim++ == 100 )
+        {
+            ptst->count--;
+#ifdef YIELD_TO_HELP_PROGRESS
+            if ( gc->reclaim_attempts_since_yield++ == 10000 )
+            {
+                gc->reclaim_attempts_since_yield = 0;
+                sched_yield();
+            }
+#endif
+            gc->entries_since_reclaim = 0;
+            if ( !gc_reclaim(ptst) ) gc_throttle(ptst);
+            goto retry;    
+        }
+    }
+#endif
+}
+
+
+unsigned long gc_epoch_count(void)
+{
+    return gc_global.epochs;
+}
+
+
+void gc_exit(ptst_t *ptst)
+{
+    MB();
+    ptst->count--;
+}
+
+
+void gc_adopt(gc_t *gc)
+{
+    /* Recycle into the pools of our own node, not the previous owner's. */
+    gc->node = gc_global.numa ? current_numa_node() : 0;
+}
+
+
+gc_t *gc_init(void)
+{
+    gc_t *gc;
+    int   i;
+
+    gc = ALIGNED_ALLOC(sizeof(*gc));
+    if ( gc == NULL ) MEM_FAIL(sizeof(*gc));
+    memset(gc, 0, sizeof(*gc));
+    gc->node = gc_global.numa ? current_numa_node() : 0;
+
+#ifdef WEAK_MEM_ORDER
+    /* Initialise shootdown state. */
+    gc->async_page = mmap(NULL, gc_global.page_size, PROT_NONE, 
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( gc->async_page == (void *)MAP_FAILED ) MEM_FAIL(gc_global.page_size);
+    gc->async_page_state = 1;
+#endif
+
+    gc->chunk_cache = get_empty_chunks(100);
+
+    /* Get ourselves a set of allocation chunks. */
+    for ( i = 0; i < gc_global.nr_sizes; i++ )
+    {
+        gc->alloc[i] = get_alloc_chunk(gc, i);
+    }
+    for ( ; i < MAX_SIZES; i++ )
+    {
+        gc->alloc[i] = chunk_from_cache(gc);
+    }
+
+    return(gc);
+}
+
+
+int gc_add_allocator(int alloc_size)
+{
+    int ni, i = gc_global.nr_sizes;
+    while ( (ni = CASIO(&gc_global.nr_sizes, i, i+1)) != i ) i = ni;
+    gc_global.blk_sizes[i]  = alloc_size;
+    gc_global.alloc_size[0][i] = ALLOC_CHUNKS_PER_LIST;
+    gc_global.alloc[0][i] = get_filled_chunks(ALLOC_CHUNKS_PER_LIST, alloc_size, 0);
+    /* The first chunk serves as the list head. */
+    gc_global.nr_added[0][i] = ALLOC_CHUNKS_PER_LIST - 1;
+    return i;
+}
+
+
+void gc_set_numa_pools(int enable)
+{
+    gc_global.numa = enable;
+}
+
+
+void gc_set_trim_watermark(size_t bytes)
+{
+    gc_global.trim_watermark = bytes;
+    gc_global.trim_at = bytes;
+}
+
+
+/* Sum the statistics of @gc into @stats. */
+static void add_stats(gc_stats_t *stats, gc_t *gc)
+{
+    int i;
+
+    stats->epochs         += gc->epochs;
+    stats->reclaims       += gc->reclaims;
+    stats->reclaim_stalls += gc->reclaim_stalls;
+    stats->reclaim_busy   += gc->reclaim_busy;
+    stats->throttles      += gc->throttles;
+    if ( gc->peak_backlog > stats->peak_backlog )
+        stats->peak_backlog = gc->peak_backlog;
+
+    for ( i = 0; i < stats->nr_sizes; i++ )
+    {
+        stats->sizes[i].allocated += gc->allocated[i];
+        stats->sizes[i].freed     += gc->freed[i] + gc->unsafe_freed[i];
+        stats->sizes[i].recycled  += gc->recycled[i] + gc->unsafe_freed[i];
+    }
+
+    for ( i = 0; i < stats->nr_hooks; i++ )
+    {
+        stats->hooks[i].queued += gc->hooks_queued[i];
+        stats->hooks[i].run    += gc->hooks_run[i];
+    }
+}
+
+
+void gc_get_stats(ptst_t *ptst, gc_stats_t *stats)
+{
+    int i;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->nr_sizes = gc_global.nr_sizes;
+    stats->trimmed  = gc_global.trimmed;
+    stats->nr_hooks = gc_global.nr_hooks;
+    for ( i = 0; i < stats->nr_sizes; i++ )
+        stats->sizes[i].size = gc_global.blk_sizes[i];
+
+    if ( ptst != NULL )
+        add_stats(stats, ptst->gc);
+    else
+        for ( ptst = ptst_first(); ptst != NULL; ptst = ptst_next(ptst) )
+            add_stats(stats, ptst->gc);
+
+    /* Counters are read racily, do not let the backlog underflow. */
+    for ( i = 0; i < stats->nr_sizes; i++ )
+        stats->sizes[i].backlog =
+            stats->sizes[i].freed > stats->sizes[i].recycled ?
+            stats->sizes[i].freed - stats->sizes[i].recycled : 0;
+    for ( i = 0; i < stats->nr_hooks; i++ )
+        stats->hooks[i].backlog =
+            stats->hooks[i].queued > stats->hooks[i].run ?
+            stats->hooks[i].queued - stats->hooks[i].run : 0;
+}
+
+
+void gc_set_backlog_limit(unsigned long blocks)
+{
+    gc_global.backlog_limit = blocks;
+}
+
+
+size_t gc_trim(void)
+{
+    size_t released;
+
+    while ( gc_global.inreclaim || CASIO(&gc_global.inreclaim, 0, 1) ) ;
+    released = trim_all();
+    gc_global.inreclaim = 0;
+
+    return released;
+}
+
+
+void gc_remove_allocator(int alloc_id)
+{
+    /* This is a no-op for now. */
+}
+
+
+int gc_add_hook(hook_fn_t fn)
+{
+    int ni, i = gc_global.nr_hooks;
+    while ( (ni = CASIO(&gc_global.nr_hooks, i, i+1)) != i ) i = ni;
+    gc_global.hook_fns[i] = fn;
+    return i;    
+}
+
+
+void gc_remove_hook(int hook_id)
+{
+    /* This is a no-op for now. */
+}
+
+
+void _destroy_gc_subsystem(void)
+{
+#ifdef PROFILE_GC
+    printf("Total heap: %u bytes (%.2fMB) in %u allocations\n",
+           gc_global.total_size, (double)gc_global.total_size / 1000000,
+           gc_global.allocations);
+#endif
+}
+
+
+void _init_gc_subsystem(void)
+{
+    /* Several queues may share the collector; only the first caller
+     * sets it up, later calls must not wipe registered allocators. */
+    if ( gc_global.page_size != 0 ) return;
+
+    memset(&gc_global, 0, sizeof(gc_global));
+
+    gc_global.page_size   = (unsigned int)sysconf(_SC_PAGESIZE);
+    gc_global.free_chunks = alloc_more_chunks();
+
+    gc_global.nr_hooks = 0;
+    gc_global.nr_sizes = 0;
+
+    gc_global.trim_watermark = DEFAULT_TRIM_WATERMARK;
+    gc_global.trim_at = DEFAULT_TRIM_WATERMARK;
+}
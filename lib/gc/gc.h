@@ -0,0 +1,129 @@
+#ifndef __GC_H__
+#define __GC_H__
+
+#include <stddef.h>
+
+typedef struct gc_st gc_t;
+
+/* Most of these functions peek into a per-thread state struct. */
+#include "ptst.h"
+
+/* Initialise GC section of given per-thread state structure. */
+gc_t *gc_init(void);
+
+/* Hand the GC section of an offline thread's state to the calling thread. */
+void gc_adopt(gc_t *gc);
+
+int gc_add_allocator(int alloc_size);
+void gc_remove_allocator(int alloc_id);
+
+/*
+ * Give each NUMA node its own allocation pools, backed by huge pages and
+ * bound to the node. Blocks freed by a thread are recycled into the pools
+ * of its node. Applies to threads entering the collector afterwards.
+ */
+void gc_set_numa_pools(int enable);
+
+/*
+ * Return pages covered by free blocks to the OS once the main allocation
+ * lists hold more than @bytes of free memory, checked on epoch advance.
+ * Zero disables trimming. gc_trim() trims right away and returns the
+ * number of bytes released.
+ */
+void gc_set_trim_watermark(size_t bytes);
+size_t gc_trim(void);
+
+/*
+ * Memory allocate/free. An unsafe free can be used when an object was
+ * not made visible to other processes. With a node allocator installed
+ * (see alloc.h), blocks come from it and are handed back to it once
+ * their epoch has passed, instead of being recycled into the pools.
+ */
+void *gc_alloc(ptst_t *ptst, int alloc_id);
+void gc_free(ptst_t *ptst, void *p, int alloc_id);
+void gc_unsafe_free(ptst_t *ptst, void *p, int alloc_id);
+
+/*
+ * Hook registry. Allows users to hook in their own per-epoch delay
+ * lists.
+ */
+typedef void (*hook_fn_t)(ptst_t *, void *);
+int gc_add_hook(hook_fn_t fn);
+void gc_remove_hook(int hook_id);
+void gc_add_ptr_to_hook_list(ptst_t *ptst, void *ptr, int hook_id);
+
+/* Per-thread entry/exit from critical regions */
+void gc_enter(ptst_t *ptst);
+void gc_exit(ptst_t *ptst);
+
+/*
+ * Number of epoch advances so far. An object which was reachable while
+ * the count was c, and is accessed from within a critical region while
+ * the count is still c, has not been reused.
+ */
+unsigned long gc_epoch_count(void);
+
+/*
+ * Bound the garbage a thread accumulates while the epoch is held up, e.g.
+ * by a descheduled thread within a critical region. Past @blocks unrecycled
+ * blocks, threads which fail to advance the epoch yield their CPU until it
+ * moves. Zero, the default, disables throttling.
+ */
+void gc_set_backlog_limit(unsigned long blocks);
+
+/* Maximum number of allocators, and of hooks. */
+#define GC_MAX_SIZES 64
+#define GC_MAX_HOOKS 4
+
+/*
+ * Collector statistics. Threads count into their own state, so keeping
+ * them costs no shared writes; they are only summed up when read, and
+ * are approximate while threads are running.
+ */
+typedef struct gc_stats_st
+{
+    /* Epoch advances, and attempts to advance. */
+    unsigned long epochs;
+    unsigned long reclaims;
+    /* Attempts given up as a thread had not yet seen the current epoch. */
+    unsigned long reclaim_stalls;
+    /* Attempts given up as another thread was reclaiming. */
+    unsigned long reclaim_busy;
+    /* Yields of threads throttled by gc_set_backlog_limit(). */
+    unsigned long throttles;
+    /* Largest garbage backlog of a single thread seen on a failed advance. */
+    unsigned long peak_backlog;
+    /* Bytes returned to the OS, see gc_set_trim_watermark(). */
+    size_t trimmed;
+
+    int nr_sizes;
+    struct
+    {
+        int size;
+        unsigned long allocated;
+        unsigned long freed;
+        /* Freed blocks back in the allocation lists, or with the node
+         * allocator if one is installed (see alloc.h). */
+        unsigned long recycled;
+        /* Freed blocks still waiting for their epoch to pass. */
+        unsigned long backlog;
+    } sizes[GC_MAX_SIZES];
+
+    /* Pointers put on hook lists, and passed to their hook since. */
+    int nr_hooks;
+    struct
+    {
+        unsigned long queued;
+        unsigned long run;
+        unsigned long backlog;
+    } hooks[GC_MAX_HOOKS];
+} gc_stats_t;
+
+/* Statistics of the thread owning @ptst, or of all threads if NULL. */
+void gc_get_stats(ptst_t *ptst, gc_stats_t *stats);
+
+/* Start-of-day initialisation of garbage collector. */
+void _init_gc_subsystem(void);
+void _destroy_gc_subsystem(void);
+
+#endif /* __GC_H__ */
@@ -21,12 +21,14 @@
 /*
  * This is a strong barrier! Reads cannot be delayed beyond a later store.
  * Reads cannot be hoisted beyond a LOCK prefix. Stores always in-order.
+ * The memory operand keeps the type of *_a, so that it does not alias
+ * the location as another type.
  */
 #define CAS(_a, _o, _n)                                    \
 ({ __typeof__(_o) __o = _o;                                \
    __asm__ __volatile__(                                   \
        "lock cmpxchg %3,%1"                                \
-       : "=a" (__o), "=m" (*(volatile unsigned int *)(_a)) \
+       : "=a" (__o), "+m" (*(_a))                          \
        :  "0" (__o), "r" (_n) );                           \
    __o;                                                    \
 })
@@ -35,7 +37,7 @@
 ({ __typeof__(_n) __o;                                     \
    __asm__ __volatile__(                                   \
        "lock xchg %0,%1"                                   \
-       : "=r" (__o), "=m" (*(volatile unsigned int *)(_a)) \
+       : "=r" (__o), "+m" (*(_a))                          \
        :  "0" (_n) );                                      \
    __o;                                                    \
 })
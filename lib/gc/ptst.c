@@ -39,6 +39,8 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,40 +49,107 @@
 #include "ptst.h"
 
 ptst_t *ptst_list = NULL;
-extern __thread ptst_t *ptst;
+__thread ptst_t *ptst;
 static unsigned int next_id = 0;
 
+/* Releases the state of exiting threads. */
+static pthread_key_t ptst_key;
+static pthread_once_t ptst_key_once = PTHREAD_ONCE_INIT;
+
+
+/*
+ * Hand a state over to the next thread coming online. Its garbage lists
+ * keep being reclaimed meanwhile, and the adopting thread continues
+ * them.
+ */
+static void
+ptst_release(ptst_t *p)
+{
+    MB();
+    p->in_use = 0;
+}
+
+
+/*
+ * A thread which exits is gone for good, even if it was within a critical
+ * region. It must not hold up epoch advance.
+ */
+static void
+ptst_destructor(void *p)
+{
+    ((ptst_t *)p)->count = 1;
+    ptst_release((ptst_t *)p);
+}
+
+
+static void
+ptst_key_init(void)
+{
+    pthread_key_create(&ptst_key, ptst_destructor);
+}
+
+
 void
-critical_enter()
+critical_online(void)
 {
     ptst_t *next, *new_next;
 
-    if ( ptst == NULL ) 
+    if ( ptst != NULL ) return;
+
+    pthread_once(&ptst_key_once, ptst_key_init);
+
+    /* Adopt the state of a thread that has gone offline, if any. */
+    for ( next = ptst_first(); next != NULL; next = ptst_next(next) )
     {
-	ptst = (ptst_t *) ALIGNED_ALLOC(sizeof(ptst_t));
-	if ( ptst == NULL ) exit(1);
-	    
-	memset(ptst, 0, sizeof(ptst_t));
-	ptst->gc = gc_init();
-	ptst->count = 1;
-	ptst->id = __sync_fetch_and_add(&next_id, 1);
-	rand_init(ptst);
-	new_next = ptst_list;
-	do {
-	    ptst->next = next = new_next;
-	} 
-	while ( (new_next = __sync_val_compare_and_swap(&ptst_list, next, ptst)) != next );
+	if ( !next->in_use && __sync_bool_compare_and_swap(&next->in_use, 0, 1) )
+	{
+	    ptst = next;
+	    gc_adopt(ptst->gc);
+	    pthread_setspecific(ptst_key, ptst);
+	    return;
+	}
     }
-    
-    gc_enter(ptst);
-    return;
+
+    ptst = (ptst_t *) ALIGNED_ALLOC(sizeof(ptst_t));
+    if ( ptst == NULL ) exit(1);
+
+    memset(ptst, 0, sizeof(ptst_t));
+    ptst->gc = gc_init();
+    ptst->count = 1;
+    ptst->in_use = 1;
+    ptst->id = __sync_fetch_and_add(&next_id, 1);
+    rand_init(ptst);
+    new_next = ptst_list;
+    do {
+	ptst->next = next = new_next;
+    } 
+    while ( (new_next = __sync_val_compare_and_swap(&ptst_list, next, ptst)) != next );
+
+    pthread_setspecific(ptst_key, ptst);
 }
 
 
+void
+critical_offline(void)
+{
+    if ( ptst == NULL ) return;
+
+    /* Not within a critical region. */
+    assert(ptst->count == 1);
 
-static void ptst_destructor(ptst_t *ptst) 
+    pthread_setspecific(ptst_key, NULL);
+    ptst_release(ptst);
+    ptst = NULL;
+}
+
+
+void
+critical_enter()
 {
-    ptst->count = 0;
+    if ( ptst == NULL ) critical_online();
+
+    gc_enter(ptst);
+    return;
 }
 
 
@@ -24,6 +24,8 @@ struct ptst_st
     /* State management */
     ptst_t      *next;
     unsigned int count;
+    /* Whether a thread owns this state, see critical_offline(). */
+    unsigned int in_use;
 
     /* Utility structures */
     gc_t        *gc;
@@ -31,6 +33,9 @@ struct ptst_st
     unsigned int rand;
 };
 
+/* State of the calling thread, shared by all users of the collector. */
+extern __thread ptst_t *ptst;
+
  /*
  * Enter/leave a critical region. A thread gets a state handle for
  * use during critical regions.
@@ -40,6 +45,16 @@ void critical_enter(void );
 
 #define critical_exit() gc_exit(ptst)
 
+/*
+ * Leave the collector, outside of critical regions. The thread's state is
+ * handed over to the next thread coming online, so that threads leaving
+ * a queue neither strand their garbage nor grow the list of states.
+ * Threads which exit go offline implicitly. critical_enter() comes back
+ * online implicitly.
+ */
+void critical_offline(void);
+void critical_online(void);
+
 /* Iterators */
 extern ptst_t *ptst_list;
 
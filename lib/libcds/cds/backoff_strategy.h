@@ -232,6 +232,120 @@ namespace cds {
         size_t exponential<SpinBkoff, YieldBkoff, Tag>::s_nExpMax = 16 * 1024 ;
         //@endcond
 
+#ifdef CDS_CXX11_THREAD_LOCAL_SUPPORT
+        /// Adaptive exponential back-off
+        /**
+            This back-off strategy is an \ref exponential back-off which learns its starting delay
+            per thread. The first back-off of a contended operation spins \p SpinBkoff as many times
+            as the thread's learned delay (at least the minimum spinning bound), and every further
+            back-off doubles the spinning until the maximum bound is exceeded, after which
+            \p YieldBkoff is applied.
+
+            Once the contended operation succeeds, that is, \p reset() is called or the back-off object
+            is destroyed, the delay it would have continued with is folded into the thread's learned delay,
+            so a thread which keeps colliding starts where its previous operations ended instead of at
+            the minimum. The learned delay is capped at the maximum bound, so a thread whose operations
+            keep ending in the yield phase spins once more before it yields.
+            Each operation which did not back off at all decays the learned delay by an eighth,
+            so the thread returns to short delays when contention fades.
+
+            The learned delay is shared by all back-off objects of the same type in a thread;
+            use the \p Tag template argument to separate the learned delays of different uses.
+        */
+        template <typename SpinBkoff, typename YieldBkoff, typename Tag=void>
+        class adaptive
+        {
+        public:
+            typedef SpinBkoff  spin_backoff    ;   ///< spin back-off strategy
+            typedef YieldBkoff yield_backoff   ;   ///< yield back-off strategy
+            typedef Tag         impl_tag        ;   ///< implementation separation tag
+
+            static size_t s_nExpMin ;   ///< Minimum spinning bound (4)
+            static size_t s_nExpMax ;   ///< Maximum spinning bound (1024), lower than \ref exponential's as a pause takes tens of cycles
+
+        protected:
+            size_t  m_nExpCur   ;   ///< Next spinning, 0 if there was no back-off since the last success
+            bool    m_bBackedOff;   ///< Whether the object has backed off at all
+            spin_backoff    m_bkSpin    ;   ///< Spinning (fast-path) phase back-off strategy
+            yield_backoff   m_bkYield   ;   ///< Yield phase back-off strategy
+
+        public:
+            /// Starts at the calling thread's learned delay
+            adaptive()
+                : m_nExpCur( 0 )
+                , m_bBackedOff( false )
+            {}
+
+            /// Learns from the operation, see \p reset()
+            ~adaptive()
+            {
+                size_t& nLearned = learned() ;
+                if ( m_nExpCur != 0 )
+                    learn() ;
+                else if ( !m_bBackedOff )
+                    nLearned -= nLearned / 8 ;
+            }
+
+            //@cond
+            void operator ()()
+            {
+                if ( m_nExpCur == 0 ) {
+                    m_nExpCur = learned() < s_nExpMin ? s_nExpMin : learned()  ;
+                    m_bBackedOff = true ;
+                }
+
+                if ( m_nExpCur <= s_nExpMax ) {
+                    for ( size_t n = 0; n < m_nExpCur; ++n )
+                        m_bkSpin()  ;
+                    m_nExpCur *= 2  ;
+                }
+                else
+                    m_bkYield() ;
+            }
+
+            void reset()
+            {
+                if ( m_nExpCur != 0 )
+                    learn() ;
+                m_bkSpin.reset()    ;
+                m_bkYield.reset()   ;
+            }
+            //@endcond
+
+            /// Returns the calling thread's learned delay
+            static size_t learned_delay()
+            {
+                return learned()    ;
+            }
+
+        protected:
+            //@cond
+            static size_t& learned()
+            {
+                static thread_local size_t s_nLearned = 0 ;
+                return s_nLearned   ;
+            }
+
+            void learn()
+            {
+                size_t& nLearned = learned() ;
+                nLearned = ( nLearned + m_nExpCur ) / 2 ;
+                if ( nLearned > s_nExpMax )
+                    nLearned = s_nExpMax ;
+                m_nExpCur = 0   ;
+            }
+            //@endcond
+        };
+
+        //@cond
+        template <typename SpinBkoff, typename YieldBkoff, typename Tag>
+        size_t adaptive<SpinBkoff, YieldBkoff, Tag>::s_nExpMin = 4 ;
+
+        template <typename SpinBkoff, typename YieldBkoff, typename Tag>
+        size_t adaptive<SpinBkoff, YieldBkoff, Tag>::s_nExpMax = 1024 ;
+        //@endcond
+#endif
+
         /// Default backoff strategy
         typedef exponential<hint, yield>    Default    ;
 
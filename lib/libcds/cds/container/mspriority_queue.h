@@ -65,6 +65,13 @@ namespace cds { namespace container {
 
             /// Disposer of removed item (only for intrusive queue)
             typedef cds::intrusive::opt::v::empty_disposer  disposer ;
+
+            /// Alignment of heap nodes
+            /**
+                Default is opt::no_special_alignment, so that neighbouring nodes
+                share cache lines. See \ref MSPriorityQueue for other layouts.
+            */
+            enum { alignment = opt::no_special_alignment } ;
         };
 
         /// Metafunction converting option list to traits
@@ -114,8 +121,10 @@ namespace cds { namespace container {
         It is possible to declare option-based queue with cds::container::mspriority_queue::make_traits
         metafunction instead of \p Traits template argument.
         Template argument list \p Options of \p %cds::container::mspriority_queue::make_traits metafunction are:
-        - opt::buffer - the buffer type for heap array. Possible type are: opt::v::static_buffer, opt::v::dynamic_buffer.
-            Default is \p %opt::v::dynamic_buffer.
+        - opt::buffer - the buffer type for heap array. Possible type are: opt::v::static_buffer, opt::v::dynamic_buffer,
+            opt::v::segmented_buffer. Default is \p %opt::v::dynamic_buffer.
+            A full queue grows its opt::v::segmented_buffer under the heap's size lock.
+            Segments never move, so nodes stay in place (and locked) while the heap grows.
             At \p %MSPriorityQueue class instantiation, the \p buffer::rebind member metafunction
             is called to change type of values stored in the buffer. So, you may specify any type of values here.
         - opt::compare - priority compare functor. No default functor is provided.
@@ -128,6 +137,13 @@ namespace cds { namespace container {
         - opt::move_policy - policy for moving item's value. Default is opt::v::assignment_move_policy.
             If the compiler supports move semantics it would be better to specify the move policy
             based on move semantics feature for type \p T.
+        - opt::alignment - alignment of heap nodes. Default is opt::no_special_alignment.
+            Heapify locks a parent together with its children, so nodes which are locked by different
+            threads at once may share a cache line. opt::cache_line_alignment puts every node on its
+            own cache line. An alignment of half a cache line (for nodes not larger than that)
+            puts each pair of siblings, which are locked together, on one cache line.
+            Any other alignment also moves the heap array away from the heap's size lock.
+            Only opt::v::segmented_buffer allocates the heap array aligned to the cache line.
 
     \par Usage
 
@@ -161,13 +177,21 @@ namespace cds { namespace container {
 
         typedef unsigned char value_placeholder_item[ sizeof(value_type) ] ;
         typedef typename cds::details::aligned_type< value_placeholder_item, alignof( value_type ) >::type value_placeholder ;
+
+        static const unsigned int c_nAlignment = options::alignment ;
+        static const size_t c_nNodeAlignment = c_nAlignment == opt::cache_line_alignment ? c_nCacheLineSize
+            : c_nAlignment == opt::no_special_alignment ? 1 : size_t( c_nAlignment ) ;
+        static_assert( (c_nNodeAlignment & (c_nNodeAlignment - 1)) == 0, "Alignment must be power of two" ) ;
         //@endcond
 
         /// Heap item type
-        struct node {
-            value_placeholder   m_Value ;   ///< Value placeholder
+        /**
+            The value is stored in place. It comes last, so small values fill the padding after the lock.
+        */
+        struct CDS_TYPE_ALIGNMENT( c_nNodeAlignment ) node {
             tag_type volatile   m_nTag  ;   ///< A tag
             mutable lock_type   m_Lock  ;   ///< Node-level lock
+            value_placeholder   m_Value ;   ///< Value placeholder
 
             /// Creates empty node
             node()
@@ -243,14 +267,20 @@ namespace cds { namespace container {
         //@endcond
 
     protected:
+        //@cond
+        typedef typename opt::details::alignment_setter< buffer_type,
+            c_nAlignment == opt::no_special_alignment ? opt::no_special_alignment : opt::cache_line_alignment >::type aligned_buffer ;
+        //@endcond
+
         item_counter_type   m_ItemCounter   ;   ///< Item counter
-        mutable lock_type   m_Lock          ;   ///< Heap's size lock
-        buffer_type         m_Heap          ;   ///< Heap array
+        mutable lock_type   m_Lock          ;   ///< Heap's size lock
+        aligned_buffer      m_Heap          ;   ///< Heap array
 
     public:
         /// Constructs empty priority queue
         /**
             For cds::opt::v::static_buffer the \p nCapacity parameter is ignored.
+            For cds::opt::v::segmented_buffer \p nCapacity is the initial capacity.
         */
         MSPriorityQueue( size_t nCapacity )
             : m_Heap( nCapacity )
@@ -264,8 +294,8 @@ namespace cds { namespace container {
 
         /// Inserts a item into priority queue
         /**
-            If the priority queue is full, the function returns \p false,
-            no item has been added.
+            If the priority queue is full and its buffer cannot grow, the function
+            returns \p false, no item has been added.
             Otherwise, the function inserts the copy of \p val into the heap
             and returns \p true.
 
@@ -277,7 +307,7 @@ namespace cds { namespace container {
 
             // Insert new item at bottom of the heap
             m_Lock.lock()   ;
-            if ( m_ItemCounter.value() >= capacity() ) {
+            if ( m_ItemCounter.value() >= capacity() && !m_Heap.grow() ) {
                 m_Lock.unlock() ;
                 return false    ;
             }
@@ -301,8 +331,8 @@ namespace cds { namespace container {
 #ifdef CDS_EMPLACE_SUPPORT
         /// Inserts a item into priority queue
         /**
-            If the priority queue is full, the function returns \p false,
-            no item has been added.
+            If the priority queue is full and its buffer cannot grow, the function
+            returns \p false, no item has been added.
             Otherwise, the function inserts a new item created from \p args arguments
             into the heap and returns \p true.
 
@@ -316,7 +346,7 @@ namespace cds { namespace container {
 
             // Insert new item at bottom of the heap
             m_Lock.lock()   ;
-            if ( m_ItemCounter.value() >= capacity() ) {
+            if ( m_ItemCounter.value() >= capacity() && !m_Heap.grow() ) {
                 m_Lock.unlock() ;
                 return false    ;
             }
@@ -115,8 +115,8 @@ namespace cds { namespace intrusive {
         It is possible to declare option-based queue with cds::intrusive::mspriority_queue::make_traits
         metafunction instead of \p Traits template argument.
         Template argument list \p Options of \p %cds::intrusive::mspriority_queue::make_traits metafunction are:
-        - opt::buffer - the buffer type for heap array. Possible type are: opt::v::static_buffer, opt::v::dynamic_buffer.
-            Default is \p %opt::v::dynamic_buffer.
+        - opt::buffer - the buffer type for heap array. Possible type are: opt::v::static_buffer, opt::v::dynamic_buffer,
+            opt::v::segmented_buffer. Default is \p %opt::v::dynamic_buffer.
             At \p %MSPriorityQueue class instantiation, the \p buffer::rebind member metafunction
             is called to change type of values stored in the buffer. So, you can specify any type of values here.
         - opt::compare - priority compare functor. No default functor is provided.
@@ -1442,6 +1442,7 @@ namespace michael {
         /// Allocates new processor descriptor
         processor_desc * new_processor_desc( unsigned int nProcessorId )
         {
+            CDS_UNUSED( nProcessorId ) ;
             processor_desc * pDesc  ;
             const size_t nPageHeapCount = m_SizeClassSelector.pageTypeCount() ;
 
@@ -1663,8 +1664,7 @@ namespace michael {
 
             m_nProcessorCount = m_Topology.processor_count()    ;
             m_arrProcDesc = new( m_AlignedHeap.alloc(sizeof(processor_desc *) * m_nProcessorCount, c_nAlignment ))
-                CDS_ATOMIC::atomic<processor_desc *>[ m_nProcessorCount ] ;
-            memset( m_arrProcDesc, 0, sizeof(processor_desc *) * m_nProcessorCount )    ;   // ?? memset for atomic<>
+                CDS_ATOMIC::atomic<processor_desc *>[ m_nProcessorCount ]() ;   // value-initialized, i.e. null
         }
 
         /// Heap destructor
@@ -6,7 +6,10 @@
 #include <cds/details/defs.h>
 #include <cds/user_setup/allocator.h>
 #include <cds/details/allocator.h>
+#include <cds/details/aligned_allocator.h>
+#include <cds/user_setup/cache_line.h>
 #include <cds/int_algo.h>
+#include <cds/cxx11_atomic.h>
 
 namespace cds { namespace opt {
 
@@ -21,6 +24,7 @@ namespace cds { namespace opt {
         Implementations:
             - opt::v::static_buffer
             - opt::v::dynamic_buffer
+            - opt::v::segmented_buffer
     */
     template <typename Type>
     struct buffer {
@@ -74,6 +78,7 @@ namespace cds { namespace opt {
             */
             static_buffer( size_t nCapacity )
             {
+                CDS_UNUSED( nCapacity ) ;
                 // Capacity must be power of 2
                 static_assert( (c_nCapacity & (c_nCapacity - 1)) == 0,  "Capacity must be power of two") ;
                 //assert( c_nCapacity == nCapacity )  ;
@@ -99,6 +104,12 @@ namespace cds { namespace opt {
                 return c_nCapacity  ;
             }
 
+            /// Static buffer cannot grow, always returns \p false
+            bool grow()
+            {
+                return false    ;
+            }
+
             /// Zeroize the buffer
             void zeroize()
             {
@@ -201,6 +212,12 @@ namespace cds { namespace opt {
                 return m_nCapacity  ;
             }
 
+            /// Dynamic buffer cannot grow, always returns \p false
+            bool grow()
+            {
+                return false    ;
+            }
+
             /// Zeroize the buffer
             void zeroize()
             {
@@ -227,6 +244,139 @@ namespace cds { namespace opt {
             //@endcond
         };
 
+        /// Growable segmented buffer
+        /**
+            One of available opt::buffer type-option.
+
+            The buffer is an array of up to \p SegmentCount segments. The first segment
+            has the initial capacity, every following segment doubles the capacity of the buffer,
+            so an item \p i is found in O(1) by its most significant bit.
+            \ref grow allocates the next segment; items already in the buffer never move,
+            so references to them stay valid while the buffer grows.
+
+            Segments are aligned to the cache line, or to the alignment of \p T if it is larger.
+
+            \ref grow must be serialized by the caller. \ref capacity and \ref operator[]
+            may be called concurrently with \ref grow: a new segment is published
+            before the capacity that covers it.
+
+            \par Template parameters:
+                \li \p T - item type storing in the buffer
+                \li \p Alloc - an aligned allocator used for allocating the segments (\p cds::OS::aligned_allocator interface)
+                \li \p SegmentCount - max number of segments
+        */
+        template <typename T, class Alloc = CDS_DEFAULT_ALIGNED_ALLOCATOR, size_t SegmentCount = 32>
+        class segmented_buffer
+        {
+        public:
+            typedef T   value_type  ;   ///< Value type
+            static const size_t c_nSegmentCount = SegmentCount ;    ///< Max number of segments
+
+            /// Rebind buffer for other template parameters
+            template <typename Q>
+            struct rebind {
+                typedef segmented_buffer<Q, Alloc, SegmentCount> other   ;  ///< Rebinding result type
+            };
+
+            //@cond
+            typedef cds::details::AlignedAllocator<value_type, Alloc>   allocator_type  ;
+            static const size_t c_nAlignment = alignof( value_type ) > c_nCacheLineSize ? alignof( value_type ) : c_nCacheLineSize ;
+            //@endcond
+
+        private:
+            //@cond
+            CDS_ATOMIC::atomic<value_type *>    m_Segments[c_nSegmentCount] ;
+            CDS_ATOMIC::atomic<size_t>          m_nCapacity     ;
+            size_t                              m_nSegments     ;   ///< Allocated segments, guarded by the caller of grow()
+            size_t const                        m_nFirstLog     ;   ///< log2 of the first segment's capacity
+            size_t const                        m_nFirst        ;   ///< The first segment's capacity
+            //@endcond
+
+        public:
+            /// Allocates the first segment of given \p nCapacity
+            /**
+                \p nCapacity is rounded up to the power of two.
+            */
+            segmented_buffer( size_t nCapacity )
+                : m_nSegments( 1 )
+                , m_nFirstLog( beans::log2floor( beans::ceil2( nCapacity < 2 ? 2 : nCapacity )))
+                , m_nFirst( size_t(1) << m_nFirstLog )
+            {
+                allocator_type a    ;
+                for ( size_t i = 1; i < c_nSegmentCount; ++i )
+                    m_Segments[i].store( null_ptr<value_type *>(), CDS_ATOMIC::memory_order_relaxed ) ;
+                m_Segments[0].store( a.NewArray( c_nAlignment, m_nFirst ), CDS_ATOMIC::memory_order_relaxed ) ;
+                m_nCapacity.store( m_nFirst, CDS_ATOMIC::memory_order_release ) ;
+            }
+
+            /// Destroys all segments
+            ~segmented_buffer()
+            {
+                allocator_type a    ;
+                for ( size_t i = 0; i < m_nSegments; ++i )
+                    a.Delete( m_Segments[i].load( CDS_ATOMIC::memory_order_relaxed ), segment_size( i ) ) ;
+            }
+
+            /// Get item \p i
+            value_type& operator []( size_t i )
+            {
+                assert( i < capacity() )    ;
+                if ( i < m_nFirst )
+                    return m_Segments[0].load( CDS_ATOMIC::memory_order_relaxed )[i] ;
+
+                // Segment k > 0 holds items [2^(k-1) * first, 2^k * first)
+                size_t nLog = beans::log2floor( i ) ;
+                return m_Segments[ nLog - m_nFirstLog + 1 ].load( CDS_ATOMIC::memory_order_acquire )[ i - (size_t(1) << nLog) ] ;
+            }
+
+            /// Get item \p i, const version
+            const value_type& operator []( size_t i ) const
+            {
+                assert( i < capacity() )    ;
+                if ( i < m_nFirst )
+                    return m_Segments[0].load( CDS_ATOMIC::memory_order_relaxed )[i] ;
+
+                // Segment k > 0 holds items [2^(k-1) * first, 2^k * first)
+                size_t nLog = beans::log2floor( i ) ;
+                return m_Segments[ nLog - m_nFirstLog + 1 ].load( CDS_ATOMIC::memory_order_acquire )[ i - (size_t(1) << nLog) ] ;
+            }
+
+            /// Returns buffer capacity
+            size_t capacity() const CDS_NOEXCEPT
+            {
+                return m_nCapacity.load( CDS_ATOMIC::memory_order_acquire ) ;
+            }
+
+            /// Doubles the capacity of the buffer
+            /**
+                Returns \p false if all \p SegmentCount segments are in use.
+                The function is not thread-safe with respect to itself.
+            */
+            bool grow()
+            {
+                if ( m_nSegments == c_nSegmentCount )
+                    return false    ;
+
+                allocator_type a    ;
+                m_Segments[m_nSegments].store( a.NewArray( c_nAlignment, segment_size( m_nSegments )), CDS_ATOMIC::memory_order_release ) ;
+                ++m_nSegments   ;
+                m_nCapacity.store( m_nFirst << (m_nSegments - 1), CDS_ATOMIC::memory_order_release ) ;
+                return true ;
+            }
+
+        private:
+            //@cond
+            size_t segment_size( size_t nSegment ) const
+            {
+                return nSegment == 0 ? m_nFirst : m_nFirst << (nSegment - 1) ;
+            }
+
+            // non-copyable
+            segmented_buffer(const segmented_buffer&) ;
+            void operator =(const segmented_buffer&);
+            //@endcond
+        };
+
     }   // namespace v
 
 }}  // namespace cds::opt
@@ -40,10 +40,15 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef LINDEN_ALIGNED_NODES
+#define _GNU_SOURCE /* posix_memalign */
+#endif
 
 #include <assert.h>
+#include <stdlib.h>
 
 /* keir fraser's garbage collection */
+#include "gc/backoff.h"
 #include "gc/ptst.h"
 
 /* some utilities (e.g. memory barriers) */
@@ -53,28 +58,122 @@
 #include "prioq.h"
 
 
-/* thread state. */
-__thread ptst_t *ptst;
+/* Per-thread observations of the adaptive offset controller. */
+typedef struct
+{
+    int  ops;       /* deletemin calls in the current window */
+    long traversed; /* sum of offsets */
+    int  attempts;  /* attempted head swings */
+    int  failures;  /* head swings lost to another thread */
+} offset_ctl_t;
+
+static __thread offset_ctl_t ctl;
+
+/* Per-thread finger: the predecessors found by this thread's last
+ * insert, on levels 0 to levels - 1. Nodes are not reused as long as the
+ * GC epoch count has not changed since the insert began. */
+typedef struct
+{
+    pq_t          *pq;
+    unsigned long epochs;
+    int           levels;
+    node_t        *preds[NUM_LEVELS];
+} finger_t;
+
+static __thread finger_t finger;
+
+/* Level generator of threads which do not use the epoch collector. */
+static __thread unsigned int smr_rand;
 
 static int gc_id[NUM_LEVELS];
 
 
+/* Size of a node with the given number of levels.
+ *
+ * With LINDEN_ALIGNED_NODES, sizes below a cache line are rounded up to
+ * a power of two, and larger sizes to whole cache lines. Since the GC
+ * carves nodes out of cache line aligned chunks, a node's key, its
+ * level 0 pointer (holding the delete flag) and its lower level
+ * pointers then always share a single cache line, and locate_preds
+ * takes at most one miss per hop instead of two.
+ */
+static size_t
+node_size(int level)
+{
+    size_t sz = sizeof(node_t) + (level - 1) * sizeof(node_t *);
+#ifdef LINDEN_ALIGNED_NODES
+    size_t p2 = sizeof(node_t *);
+    if (sz > CACHE_LINE_SIZE)
+	return (sz + CACHE_LINE_SIZE - 1) & ~((size_t)CACHE_LINE_SIZE - 1);
+    while (p2 < sz)
+	p2 <<= 1;
+    sz = p2;
+#endif
+    return sz;
+}
+
+/* Allocate a sentinel node of NUM_LEVELS levels. */
+static node_t *
+alloc_sentinel(void)
+{
+#ifdef LINDEN_ALIGNED_NODES
+    void *n;
+    if (posix_memalign(&n, CACHE_LINE_SIZE, node_size(NUM_LEVELS)) != 0)
+	return NULL;
+    return n;
+#else
+    return malloc(node_size(NUM_LEVELS));
+#endif
+}
+
+
+/* Enter and leave an operation's critical region. */
+static inline void
+pq_enter(pq_t *pq)
+{
+    if (pq->smr == NULL)
+	critical_enter();
+    else
+	pq->smr->enter();
+}
+
+static inline void
+pq_exit(pq_t *pq)
+{
+    if (pq->smr == NULL)
+	critical_exit();
+    else
+	pq->smr->exit();
+}
+
+
 /* initialize new node */
 static node_t *
 alloc_node(pq_t *q)
 {
     node_t *n;
     int level = 1;
+    unsigned int *seed, r;
+    if (q->smr == NULL) {
+	seed = &ptst->rand;
+    } else {
+	seed = &smr_rand;
+	if (*seed == 0)
+	    *seed = (unsigned int)(uintptr_t)seed;
+    }
     /* crappy rng */
-    unsigned int r = ptst->rand;
-    ptst->rand = r * 1103515245 + 12345;
+    r = *seed;
+    *seed = r * 1103515245 + 12345;
     r &= (1u << (NUM_LEVELS - 1)) - 1;
     /* uniformly distributed bits => geom. dist. level, p = 0.5 */
     while ((r >>= 1) & 1)
 	++level;
     assert(1 <= level && level <= 32);
 
-    n = gc_alloc(ptst, gc_id[level - 1]);
+    if (q->smr == NULL)
+	n = gc_alloc(ptst, gc_id[level - 1]);
+    else
+	n = q->smr->alloc(node_size(level));
     n->level = level;
     n->inserting = 1;
     /* necessary to make one of the unit tests to work properly */
@@ -85,9 +184,12 @@ alloc_node(pq_t *q)
 
 /* Mark node as ready for reclamation to the garbage collector. */
 static void 
-free_node(node_t *n)
+free_node(pq_t *pq, node_t *n)
 {
-    gc_free(ptst, (void *)n, gc_id[(n->level) - 1]);
+    if (pq->smr == NULL)
+	gc_free(ptst, (void *)n, gc_id[(n->level) - 1]);
+    else
+	pq->smr->retire(n);
 }
 
 
@@ -118,13 +220,11 @@ free_node(node_t *n)
  */
 
 static node_t *
-locate_preds(pq_t *pq, pkey_t k, node_t **preds, node_t **succs)
+locate_preds(node_t *x, int i, pkey_t k, node_t **preds, node_t **succs)
 {
-    node_t *x, *x_next, *del = NULL;
-    int d = 0, i;
+    node_t *x_next, *del = NULL;
+    int d = 0;
 
-    x = pq->head;
-    i = NUM_LEVELS - 1;
     while (i >= 0)
     {
 	x_next = x->next[i];
@@ -151,8 +251,77 @@ locate_preds(pq_t *pq, pkey_t k, node_t **preds, node_t **succs)
     return del;
 }
 
-/***** insert *****
- * Insert a new node n with key k and value v.
+/***** locate *****
+ * Record predecessors and successors of key k on the given number of
+ * lowest levels, as locate_preds, starting from the finger f if it is
+ * not NULL. The caller must be in a critical region in which all of
+ * f's nodes are known not to have been reused.
+ *
+ * Starting at the new node's top level, the search climbs the finger
+ * until the successor there is behind the insertion point, and
+ * descends from that predecessor as usual, so inserts close to the
+ * one which recorded the finger only touch a few nodes. The finger is
+ * unusable if it belongs to another queue or covers too few levels, or
+ * if its start node is behind the insertion point. Deleted nodes in
+ * the finger are fine: they stay readable, their level 0 pointers
+ * never change, and locate_preds skips them as it does from the head.
+ *
+ * Otherwise the search starts at the head, on the highest level ever
+ * used by a node. The predecessors found are recorded in f.
+ */
+static node_t *
+locate(pq_t *pq, finger_t *f, pkey_t k, int levels,
+       node_t **preds, node_t **succs)
+{
+    node_t *del, *x, *s;
+    int i;
+
+    if (f == NULL)
+	return locate_preds(pq->head, pq->max_level - 1, k, preds, succs);
+
+    if (f->pq != pq || f->levels < levels)
+	goto head;
+
+    /* Climb until the finger's successor is behind the insertion
+     * point, which as in locate_preds lies after all smaller and all
+     * deleted keys. */
+    for (i = levels - 1; i + 1 < f->levels; i++) {
+	s = get_unmarked_ref(f->preds[i]->next[i]);
+	if (s->k >= k && !is_marked_ref(s->next[0]))
+	    break;
+    }
+
+    /* The start must be before the insertion point as well. */
+    x = f->preds[i];
+    if (x->k >= k && !is_marked_ref(x->next[0]))
+	goto head;
+
+    del = locate_preds(x, i, k, preds, succs);
+    memcpy(f->preds, preds, (i + 1) * sizeof(node_t *));
+    return del;
+
+head:
+    f->pq = pq;
+    f->levels = pq->max_level;
+    del = locate_preds(pq->head, f->levels - 1, k, preds, succs);
+    memcpy(f->preds, preds, f->levels * sizeof(node_t *));
+    return del;
+}
+
+
+/* Raise the highest level in use to at least level. */
+static void
+raise_max_level(pq_t *pq, int level)
+{
+    int l;
+    while ((l = pq->max_level) < level)
+	__sync_bool_compare_and_swap(&pq->max_level, l, level);
+}
+
+
+/***** insert_node *****
+ * Insert a new node n with key k and value v, from within a critical
+ * region, searching from the finger f if it is not NULL (see locate).
  * The node will not be inserted if another node with key k is already
  * present in the list.
  *
@@ -161,30 +330,30 @@ locate_preds(pq_t *pq, pkey_t k, node_t **preds, node_t **succs)
  * top. Conditioned on that succs[i] is still the successor of
  * preds[i], n will be spliced in on level i.
  */
-void 
-insert(pq_t *pq, pkey_t k, pval_t v)
+static void
+insert_node(pq_t *pq, finger_t *f, pkey_t k, pval_t v, backoff_t *b)
 {
     node_t *preds[NUM_LEVELS], *succs[NUM_LEVELS];
-    node_t *new = NULL, *del = NULL;
-    
-    assert(SENTINEL_KEYMIN < k && k < SENTINEL_KEYMAX);
-    critical_enter();
-    
+    node_t *new, *del;
     /* Initialise a new node for insertion. */
     new    = alloc_node(pq);
     new->k = k;
     new->v = v;
 
+    /* Searches starting at the head must cover the new node's levels
+     * before it becomes visible. */
+    raise_max_level(pq, new->level);
+
     /* lowest level insertion retry loop */
 retry:
-    del = locate_preds(pq, k, preds, succs);
+    del = locate(pq, f, k, new->level, preds, succs);
 
     /* return if key already exists, i.e., is present in a non-deleted
      * node */
     if (succs[0]->k == k && !is_marked_ref(preds[0]->next[0]) && preds[0]->next[0] == succs[0]) {
 	new->inserting = 0;
-	free_node(new);
-	goto out;
+	free_node(pq, new);
+	return;
     }
     new->next[0] = succs[0];
 
@@ -194,6 +363,7 @@ retry:
 	/* either succ has been deleted (modifying preds[0]),
 	 * or another insert has succeeded or preds[0] is head, 
 	 * and a restructure operation has updated it */
+	backoff(b);
 	goto retry;
     }
 
@@ -215,7 +385,8 @@ retry:
         if (!__sync_bool_compare_and_swap(&preds[i]->next[i], succs[i], new))
         {
 	    /* failed due to competing insert or restruct */
-            del = locate_preds(pq, k, preds, succs);
+	    backoff(b);
+            del = locate(pq, f, k, new->level, preds, succs);
 
 	    /* if new has been deleted, we're done */
 	    if (succs[0] != new) goto success;
@@ -226,13 +397,74 @@ retry:
 	}
     }
 success:
-    if (new) {
-        IWMB(); /* this flag must be reset after all CAS have completed */
-	new->inserting = 0;
-    }
+    IWMB(); /* this flag must be reset after all CAS have completed */
+    new->inserting = 0;
+}
+
+
+/***** insert *****
+ * Insert key k with value v, see insert_node.
+ *
+ * If enabled, the search starts from the calling thread's finger, the
+ * predecessors found by its previous insert. The finger is dropped if
+ * any of its nodes may have been reused, i.e. the epoch count changed
+ * since the insert recording it began. Validating it takes the epoch
+ * collector.
+ */
+void 
+insert(pq_t *pq, pkey_t k, pval_t v)
+{
+    finger_t *f = NULL;
+    backoff_t b;
+    /* Read before entering, so that nodes found in this critical
+     * region are not reused while the count is still epochs. */
+    unsigned long epochs = gc_epoch_count();
     
-out:    
-    critical_exit();
+    assert(SENTINEL_KEYMIN < k && k < SENTINEL_KEYMAX);
+    backoff_init(&b);
+    pq_enter(pq);
+
+    if (pq->finger && pq->smr == NULL) {
+	f = &finger;
+	/* Compared to the count within the region: the count may have
+	 * moved on several times before we entered. */
+	if (f->epochs != gc_epoch_count())
+	    f->pq = NULL;
+	f->epochs = epochs;
+    }
+    insert_node(pq, f, k, v, &b);
+
+    pq_exit(pq);
+    backoff_done(&b);
+}
+
+
+/***** insert_sorted *****
+ * Insert the n keys ks, in ascending order, with values vs, as if by
+ * insert, within a single critical region.
+ *
+ * Each key is searched for from the predecessors of the previous one,
+ * kept in a finger local to the batch: nodes reached within the same
+ * critical region are not reused, so neighbouring keys share most of
+ * their traversal regardless of the reclamation scheme.
+ */
+void
+insert_sorted(pq_t *pq, const pkey_t *ks, const pval_t *vs, int n)
+{
+    finger_t f;
+    backoff_t b;
+    int i;
+
+    f.pq = NULL;
+    backoff_init(&b);
+    pq_enter(pq);
+    for (i = 0; i < n; i++) {
+	assert(SENTINEL_KEYMIN < ks[i] && ks[i] < SENTINEL_KEYMAX);
+	assert(i == 0 || ks[i - 1] <= ks[i]);
+	insert_node(pq, &f, ks[i], vs[i], &b);
+    }
+    pq_exit(pq);
+    backoff_done(&b);
 }
 
 
@@ -260,7 +492,11 @@ static void
 restructure(pq_t *pq)
 {
     node_t *pred, *cur, *h;
-    int i = NUM_LEVELS - 1;
+    backoff_t b;
+    /* Levels above the highest one in use point to the tail. */
+    int i = pq->max_level - 1;
+
+    backoff_init(&b);
 
     pred = pq->head;
     while (i > 0) {
@@ -283,7 +519,45 @@ restructure(pq_t *pq)
 	/* swing head pointer */
 	if (__sync_bool_compare_and_swap(&pq->head->next[i],h,cur))
 	    i--;
+	else
+	    backoff(&b);
     }
+    backoff_done(&b);
+}
+
+
+/***** adapt_offset *****
+ * Record the outcome of a deletemin, and adjust max_offset once per
+ * OFFSET_WINDOW calls. When more than a quarter of the head swings are
+ * lost to other threads, restructuring is too frequent for the level of
+ * contention and the threshold is doubled. When swings are rarely lost
+ * but traversals are longer than the threshold, the dead prefix is
+ * reclaimed too late and the threshold is decreased by an eighth.
+ */
+static void
+adapt_offset(pq_t *pq, int offset, int attempted, int failed)
+{
+    int mo;
+
+    ctl.ops++;
+    ctl.traversed += offset;
+    ctl.attempts  += attempted;
+    ctl.failures  += failed;
+
+    if (ctl.ops < OFFSET_WINDOW) return;
+
+    /* Racing adjustments may overwrite each other, any of them will
+     * do. */
+    mo = __atomic_load_n(&pq->max_offset, __ATOMIC_RELAXED);
+    if (ctl.failures * 4 > ctl.attempts)
+	mo = min(2 * mo, MAX_OFFSET);
+    else if (ctl.traversed > (long)mo * ctl.ops)
+	mo = max(mo - max(mo / 8, 1), MIN_OFFSET);
+
+    if (mo != __atomic_load_n(&pq->max_offset, __ATOMIC_RELAXED))
+	__atomic_store_n(&pq->max_offset, mo, __ATOMIC_RELAXED);
+
+    memset(&ctl, 0, sizeof(ctl));
 }
 
 
@@ -300,12 +574,12 @@ deletemin(pq_t *pq)
 {
     pval_t   v = NULL;
     node_t *x, *nxt, *obs_head = NULL, *newhead, *cur;
-    int offset, lvl;
+    int offset, lvl, attempted, failed;
     
     newhead = NULL;
-    offset = lvl = 0;
+    offset = lvl = attempted = failed = 0;
 
-    critical_enter();
+    pq_enter(pq);
 
     x = pq->head;
     obs_head = x->next[0];
@@ -347,14 +621,24 @@ deletemin(pq_t *pq)
 
     /* if the offset is big enough, try to update the head node and
      * perform memory reclamation */
-    if (offset <= pq->max_offset) goto out;
+    if (offset <= __atomic_load_n(&pq->max_offset, __ATOMIC_RELAXED))
+	goto out;
+
+    attempted = 1;
 
     /* Optimization. Marginally faster */
-    if (pq->head->next[0] != obs_head) goto out;
+    if (pq->head->next[0] != obs_head) {
+	failed = 1;
+	goto out;
+    }
     
     /* try to swing the lowest level head pointer to point to newhead,
      * which is deleted */
-    if (__sync_bool_compare_and_swap(&pq->head->next[0], obs_head, get_marked_ref(newhead)))
+    if (!__sync_bool_compare_and_swap(&pq->head->next[0], obs_head, get_marked_ref(newhead)))
+    {
+	failed = 1;
+    }
+    else
     {
 	/* Update higher level pointers. */
 	restructure(pq);
@@ -368,12 +652,13 @@ deletemin(pq_t *pq)
 	while (cur != get_unmarked_ref(newhead)) {
 	    nxt = get_unmarked_ref(cur->next[0]);
 	    assert(is_marked_ref(cur->next[0]));
-	    free_node(cur);
+	    free_node(pq, cur);
 	    cur = nxt;
 	}
     }
 out:
-    critical_exit();
+    if (pq->adaptive) adapt_offset(pq, offset, attempted, failed);
+    pq_exit(pq);
     return v;
 }
 
@@ -388,8 +673,8 @@ pq_init(int max_offset)
     int i;
 
     /* head and tail nodes */
-    t = malloc(sizeof *t + (NUM_LEVELS-1)*sizeof(node_t *));
-    h = malloc(sizeof *h + (NUM_LEVELS-1)*sizeof(node_t *));
+    t = alloc_sentinel();
+    h = alloc_sentinel();
 
     t->inserting = 0;
     h->inserting = 0;
@@ -406,23 +691,55 @@ pq_init(int max_offset)
     pq->head = h;
     pq->tail = t;
     pq->max_offset = max_offset;
+    pq->max_level = 1;
+    pq->adaptive = 0;
+    pq->finger = 0;
+    pq->smr = NULL;
 
+    /* Levels of equal size share an allocator. */
     for (i = 0; i < NUM_LEVELS; i++ )
-	gc_id[i] = gc_add_allocator(sizeof(node_t) + i*sizeof(node_t *));
+	gc_id[i] = (i > 0 && node_size(i + 1) == node_size(i)) ? gc_id[i - 1]
+	    : gc_add_allocator(node_size(i + 1));
 
     return pq;
 }
 
-/* Cleanup, mark all the nodes for recycling. */
+/* Enable or disable runtime adaption of max_offset. */
+void
+pq_set_adaptive(pq_t *pq, int adaptive)
+{
+    pq->adaptive = adaptive;
+}
+
+/* Enable or disable finger search for inserts. */
+void
+pq_set_finger(pq_t *pq, int finger)
+{
+    pq->finger = finger;
+}
+
+/* Reclaim nodes with smr instead of the epoch collector. Must be set
+ * before the first insert. Finger search is not available with it. */
+void
+pq_set_smr(pq_t *pq, const pq_smr_t *smr)
+{
+    pq->smr = smr;
+}
+
+/* Cleanup, mark all the nodes for recycling. The sentinels are not part
+ * of any allocator and are released below. */
 void
 pq_destroy(pq_t *pq)
 {
     node_t *cur, *pred;
-    cur = pq->head;
+    cur = get_unmarked_ref(pq->head->next[0]);
     while (cur != pq->tail) {
 	pred = cur;
 	cur = get_unmarked_ref(pred->next[0]);
-	free_node(pred);
+	if (pq->smr == NULL)
+	    free_node(pq, pred);
+	else
+	    pq->smr->free(pred);
     }
     free(pq->tail);
     free(pq->head);
@@ -22,11 +22,35 @@ typedef struct node_s
     struct node_s *next[1];
 } node_t;
 
+/* Bounds of the restructuring threshold in adaptive mode. */
+#define MIN_OFFSET 4
+#define MAX_OFFSET (1 << 12)
+/* Number of deletemin calls after which a thread adapts the threshold. */
+#define OFFSET_WINDOW 1024
+
+/* Safe memory reclamation scheme for the nodes. By default (no scheme
+ * set), nodes come from Fraser's epoch based collector. Otherwise enter
+ * and exit bracket every insert and deletemin, alloc returns a new node
+ * of the given size, retire hands over a node which has been unlinked
+ * but may still be read by other threads, and free releases a node no
+ * other thread can reach. */
+typedef struct
+{
+    void  (*enter)(void);
+    void  (*exit)(void);
+    void *(*alloc)(size_t size);
+    void  (*retire)(void *p);
+    void  (*free)(void *p);
+} pq_smr_t;
+
 typedef struct
 {
-    int    max_offset;
-    int    max_level;
+    int    max_offset; /* read and written with relaxed atomics */
+    int    max_level; /* highest level of any inserted node */
     int    nthreads;
+    int    adaptive; /* adapt max_offset to contention at runtime */
+    int    finger;   /* start inserts at the thread's last insertion */
+    const pq_smr_t *smr; /* NULL for the epoch collector */
     node_t *head;
     node_t *tail;
     char   pad[128];
@@ -41,10 +65,18 @@ typedef struct
 
 extern pq_t *pq_init(int max_offset);
 
+extern void pq_set_adaptive(pq_t *pq, int adaptive);
+
+extern void pq_set_finger(pq_t *pq, int finger);
+
+extern void pq_set_smr(pq_t *pq, const pq_smr_t *smr);
+
 extern void pq_destroy(pq_t *pq);
 
 extern void insert(pq_t *pq, pkey_t k, pval_t v);
 
+extern void insert_sorted(pq_t *pq, const pkey_t *ks, const pval_t *vs, int n);
+
 extern pval_t deletemin(pq_t *pq);
 
 extern void sequential_length(pq_t *pq);
@@ -25,6 +25,7 @@
  */
 
 #include "fraser.h"
+#include "gc/backoff.h"
 
 extern ALIGNED(64) uint8_t levelmax[64];
 
@@ -47,15 +48,20 @@ uintptr_t set_mark(uintptr_t i)
 void fraser_search(sl_intset_t *set, val_t val, sl_node_t **left_list, sl_node_t **right_list)
 {
   int i;
-  sl_node_t *left, *left_next, *right, *right_next;
+  sl_node_t *left, *left_next, *right, *right_next, *n, *n_next;
+  backoff_t b;
 
+  backoff_init(&b);
 retry:
   left = set->head;
   for (i = *levelmax - 1; i >= 0; i--)
   {
     left_next = left->next[i];
     if (is_marked((uintptr_t)left_next))
+    {
+      backoff(&b);
       goto retry;
+    }
     /* Find unmarked node pair at this level */
     for (right = left_next; ; right = right_next)
     {
@@ -73,28 +79,83 @@ retry:
       left_next = right_next;
     }
     /* Ensure left and right nodes are adjacent */
-    if ((left_next != right) && 
-        (!ATOMIC_CAS_MB(&left->next[i], left_next, right)))
-      goto retry;
+    if (left_next != right)
+    {
+      if (!ATOMIC_CAS_MB(&left->next[i], left_next, right))
+      {
+        backoff(&b);
+        goto retry;
+      }
+      /* We snipped the marked nodes in between out of level i */
+      for (n = left_next; n != right; n = n_next)
+      {
+        n_next = (sl_node_t *)unset_mark((uintptr_t)n->next[i]);
+        sl_unlink_levels(n, 1);
+      }
+    }
     if (left_list != NULL)
       left_list[i] = left;
     if (right_list != NULL)	
       right_list[i] = right;
   }
+  backoff_done(&b);
+}
+
+/*
+ * Snip all marked nodes with keys up to bound out of every level, in a
+ * single pass per level. Unlike fraser_search(), which only cleans the
+ * path to a key, this also removes the dead nodes the search path skips
+ * over, e.g. the dead prefix that sprayed deletes leave behind. A level
+ * is given up on once the node we stand on gets deleted itself.
+ */
+void
+fraser_unlink_upto(sl_intset_t *set, val_t bound)
+{
+  int i;
+  sl_node_t *left, *left_next, *right, *right_next, *n, *n_next;
+
+  for (i = *levelmax - 1; i >= 0; i--)
+  {
+    left = set->head;
+    while (1)
+    {
+      left_next = left->next[i];
+      if (is_marked((uintptr_t)left_next))
+        break;
+      /* Skip a sequence of marked nodes */
+      for (right = left_next; ; right = (sl_node_t *)unset_mark((uintptr_t)right_next))
+      {
+        right_next = right->next[i];
+        if (!is_marked((uintptr_t)right_next))
+          break;
+      }
+      if (left_next != right)
+      {
+        if (!ATOMIC_CAS_MB(&left->next[i], left_next, right))
+          continue;
+        for (n = left_next; n != right; n = n_next)
+        {
+          n_next = (sl_node_t *)unset_mark((uintptr_t)n->next[i]);
+          sl_unlink_levels(n, 1);
+        }
+      }
+      if (right_next == NULL || right->val > bound)
+        break;
+      left = right;
+    }
+  }
 }
 
   int 
 fraser_find(sl_intset_t *set, val_t val) 
 {
-  sl_node_t **succs;
+  sl_node_t *succs[SL_MAX_LEVELS];
   int result;
 
-  /* succs = (sl_node_t **)malloc(*levelmax * sizeof(sl_node_t *)); */
-  succs = (sl_node_t **)ssalloc(*levelmax * sizeof(sl_node_t *));
+  critical_enter();
   fraser_search(set, val, NULL, succs);
   result = (succs[0]->val == val && !succs[0]->deleted);
-  /* free(succs); */
-  ssfree(succs);
+  critical_exit();
   return result;
 }
 
@@ -119,11 +180,10 @@ void mark_node_ptrs(sl_node_t *n)
   int
 fraser_remove(sl_intset_t *set, val_t val, int remove_succ)
 {
-  sl_node_t **succs;
+  sl_node_t *succs[SL_MAX_LEVELS];
   int result;
 
-  /* succs = (sl_node_t **)malloc(*levelmax * sizeof(sl_node_t *)); */
-  succs = (sl_node_t **)ssalloc(*levelmax * sizeof(sl_node_t *));
+  critical_enter();
   fraser_search(set, val, NULL, succs);
 
   if (remove_succ) {
@@ -145,6 +205,8 @@ fraser_remove(sl_intset_t *set, val_t val, int remove_succ)
 
   if (ATOMIC_FETCH_AND_INC_FULL(&succs[0]->deleted) == 0)
   {
+    sl_size_add(set, -1);
+
     /* 2. Mark forward pointers, then search will remove the node */
     mark_node_ptrs(succs[0]);
 
@@ -157,8 +219,7 @@ fraser_remove(sl_intset_t *set, val_t val, int remove_succ)
     result = 0;
   }  
 end:
-  /* free(succs); */
-  ssfree(succs);
+  critical_exit();
 
   return result;
 }
@@ -166,15 +227,16 @@ end:
   int
 fraser_insert(sl_intset_t *set, val_t v) 
 {
-  sl_node_t *new, *new_next, *pred, *succ, **succs, **preds;
+  sl_node_t *new, *new_next, *pred, *succ;
+  /* The height may grow while we insert, size for the largest one */
+  sl_node_t *preds[SL_MAX_LEVELS], *succs[SL_MAX_LEVELS];
   int i;
   int result = 0;
+  backoff_t b;
 
+  backoff_init(&b);
+  critical_enter();
   new = sl_new_simple_node(v, get_rand_level(), 0);
-  /* preds = (sl_node_t **)malloc(*levelmax * sizeof(sl_node_t *)); */
-  /* succs = (sl_node_t **)malloc(*levelmax * sizeof(sl_node_t *)); */
-  preds = (sl_node_t **)ssalloc(*levelmax * sizeof(sl_node_t *));
-  succs = (sl_node_t **)ssalloc(*levelmax * sizeof(sl_node_t *));
 
 retry: 	
   fraser_search(set, v, preds, succs);
@@ -202,6 +264,7 @@ retry:
   /* Node is visible once inserted at lowest level */
   if (!ATOMIC_CAS_MB(&preds[0]->next[0], succs[0], new))
   {
+    backoff(&b);
     goto retry;
   }
 
@@ -215,11 +278,11 @@ retry:
       new_next = new->next[i];
       if (is_marked((uintptr_t) new_next))
       {
-        goto success;
+        goto give_up;
       }
       if ((new_next != succ) && 
           (!ATOMIC_CAS_MB(&new->next[i], unset_mark((uintptr_t)new_next), succ)))
-        break; /* Give up if pointer is marked */
+        goto give_up; /* Give up if pointer is marked */
       /* Check for old reference to a k node */
       if (succ->val == v)
         succ = (sl_node_t *)unset_mark((uintptr_t)succ->next);
@@ -228,18 +291,21 @@ retry:
         break;
 
       /* MEM_BARRIER; */
+      backoff(&b);
       fraser_search(set, v, preds, succs);
     }
   }
+  goto success;
 
+give_up:
+  /* The node is being deleted, levels i and up will never be linked */
+  sl_unlink_levels(new, new->toplevel - i);
 success:
+  sl_size_add(set, 1);
   result = 1;
 end:
-  /* free(preds); */
-  /* free(succs); */
-  ssfree(preds);
-  ssfree(succs);
-
+  critical_exit();
+  backoff_done(&b);
 
   return result;
 }
@@ -32,6 +32,7 @@
 int fraser_find(sl_intset_t *set, val_t val);
 int fraser_remove(sl_intset_t *set, val_t val, int remove_succ);
 int fraser_insert(sl_intset_t *set, val_t v);
+void fraser_unlink_upto(sl_intset_t *set, val_t bound);
 
 inline int is_marked(uintptr_t i);
 inline uintptr_t unset_mark(uintptr_t i);
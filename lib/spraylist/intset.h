@@ -32,3 +32,5 @@ int sl_remove_succ(sl_intset_t *set, val_t val, int transactional);
 // priority queue
 int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d);
 int spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d);
+void spray_join(sl_intset_t *set, thread_data_t *d);
+void spray_leave(sl_intset_t *set, thread_data_t *d);
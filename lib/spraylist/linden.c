@@ -53,9 +53,6 @@
 #include "linden.h"
 
 
-/* thread state. */
-__thread ptst_t *ptst;
-
 static int gc_id[NUM_LEVELS];
 
 
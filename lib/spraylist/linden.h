@@ -46,6 +46,15 @@ typedef ALIGNED(64) struct thread_data {
   int first_remove;
   unsigned long nb_collisions;
   unsigned long nb_clean;
+  /* Adaptive spray, see spray_delete_min() */
+  sl_intset_t *spray_set;
+  int spray_width;
+  unsigned long spray_ops;
+  unsigned long spray_collisions;
+  unsigned long spray_misses;
+  int spray_dead;
+  /* Deletes by number of failed sprays, the last entry fell back */
+  unsigned long spray_retries[SL_SPRAY_RETRIES + 1];
   unsigned long nb_add;
   unsigned long nb_added;
   unsigned long nb_remove;
@@ -13,6 +13,16 @@
 #define SCANINC 0
 //SCANSKIP is # of levels to go down at each step; must be > 0
 #define SCANSKIP 1
+// CLEAN: 1 in CLEAN deletes is a naive delete_min ('cleaner')
+#define CLEAN n
+
+// The adaptive spray reconsiders its jump length every SPRAY_WINDOW
+// sprays. It widens above 1 collision in SPRAY_WIDEN sprays, narrows
+// below 1 in SPRAY_NARROW, and stays within SPRAY_MAX_WIDTH times SCANMAX.
+#define SPRAY_WINDOW 128
+#define SPRAY_WIDEN 8
+#define SPRAY_NARROW 64
+#define SPRAY_MAX_WIDTH 4
 
 
 static int _old_MarsagliaXOR(int seed) {
@@ -47,7 +57,7 @@ static int _MarsagliaXOR(int seed) {
   return seed;
 }
 
-int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
+static int _naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
   sl_node_t *first;
   int result;
 
@@ -57,6 +67,10 @@ int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
     do {
       first = (sl_node_t*)unset_mark((uintptr_t)first->next[0]);
     } while(first->next[0] && first->deleted);
+   // Only the tail is left, which must never be deleted
+   if (!first->next[0]) {
+     return 0;
+   }
    if (ATOMIC_FETCH_AND_INC_FULL(&first->deleted) != 0) {
      d->nb_collisions++;
    } else {
@@ -64,13 +78,10 @@ int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
    }
   }
 
-  result = (first->next[0] != NULL);
-  if (!result) {
-    return 1;
-  }
-  
+  result = 1;
   *val = (first->val);
   mark_node_ptrs(first);
+  sl_size_add(set, -1);
 
   // unsigned int *seed = &d->seed2;
   // *seed = _MarsagliaXOR(*seed);
@@ -84,24 +95,87 @@ int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
   return result; 
 }
 
-int spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
-  unsigned int n = d->nb_threads;
+/* Widen the spray when deletes collide often, narrow it when they
+ * hardly ever do, for a better rank. Sprays which end within the dummy
+ * range, or land on an already deleted node, count as collisions too:
+ * they fail, or walk a dead prefix a wider spray would have spread out. */
+static void _spray_adapt(thread_data_t *d, int scanmax) {
+  unsigned long collisions;
+
+  if (++d->spray_ops < SPRAY_WINDOW)
+    return;
+
+  collisions = d->nb_collisions - d->spray_collisions + d->spray_misses;
+  if (collisions * SPRAY_WIDEN > d->spray_ops &&
+      scanmax + d->spray_width < SPRAY_MAX_WIDTH * scanmax)
+    d->spray_width++;
+  else if (collisions * SPRAY_NARROW < d->spray_ops &&
+           scanmax + d->spray_width > 1)
+    d->spray_width--;
+
+  d->spray_ops = 0;
+  d->spray_misses = 0;
+  d->spray_collisions = d->nb_collisions;
+}
+
+/* Sprayed deletes are not unlinked one by one. Instead, once the set
+ * holds about SL_SPRAY_DEAD of them per thread, the thread noticing it
+ * unlinks all dead nodes up to the largest sprayed key in one pass. */
+static void _spray_unlink(sl_intset_t *set, thread_data_t *d, unsigned int n, val_t val) {
+  long dead;
+  val_t bound;
+
+  if (val > set->dead_max)
+    set->dead_max = val; // Racy, an estimate is good enough
+
+  if (++d->spray_dead < SL_SPRAY_DEAD_BATCH)
+    return;
+
+  dead = __sync_add_and_fetch(&set->dead, d->spray_dead);
+  d->spray_dead = 0;
+  if (dead < SL_SPRAY_DEAD * n)
+    return;
+
+  // Only one of the threads crossing the threshold gets to clean
+  if (__sync_lock_test_and_set(&set->dead, 0) < SL_SPRAY_DEAD * n)
+    return;
+
+  bound = set->dead_max;
+  set->dead_max = 0;
+  fraser_unlink_upto(set, bound);
+}
+
+static int _spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
+  const sl_spray_t *p = &set->spray;
+  /* Spray across the live threads rather than the configured ones */
+  unsigned int n = (p->adaptive && set->threads > 0) ? set->threads : d->nb_threads;
   unsigned int *seed = &d->seed2;
+  int clean = p->clean ? p->clean : CLEAN;
 
 #ifndef DISTRIBUTION_EXPERIMENT 
   *seed = _MarsagliaXOR(*seed);
-  if (n == 1 || *seed % n/*/floor_log_2(n)*/ == 0) { // n == 1 is equivalent to naive delete_min
+  if (n == 1 || *seed % clean/*/floor_log_2(n)*/ == 0) { // n == 1 is equivalent to naive delete_min
     d->nb_clean++;
-    return naive_delete_min(set, val, d);
+    return _naive_delete_min(set, val, d);
   }
 #endif
 
   sl_node_t *cur;
   int result;
   int scanlen;
-  int height = SCANHEIGHT; 
-  int scanmax = SCANMAX;
-  int scan_inc = SCANINC;
+  int height = p->height ? p->height : SCANHEIGHT;
+  int scanmax = p->scanmax ? p->scanmax : SCANMAX;
+  int scan_inc = p->scaninc;
+  int scan_skip = p->scanskip > 0 ? p->scanskip : SCANSKIP;
+
+  if (p->adaptive) {
+    _spray_adapt(d, scanmax);
+    scanmax += d->spray_width;
+  }
+
+  /* Start within the current height of the list */
+  if (height > *levelmax - 1)
+    height = *levelmax - 1;
 
   cur = set->head;
 
@@ -127,14 +201,18 @@ int spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
     if (!cur->next[0]) return 0; //got to end of list
 
     scanmax += scan_inc;
+    if (scanmax < 0) scanmax = 0;
 
     if (i == 0) break;
-    if (i <= SCANSKIP) { i = 0; continue; } // need to guarantee bottom level gets scanned
-    i -= SCANSKIP;
+    if (i <= scan_skip) { i = 0; continue; } // need to guarantee bottom level gets scanned
+    i -= scan_skip;
   }
 
+  if (cur == set->head || cur->deleted)
+    d->spray_misses++;
+
   if (cur == set->head) // still in dummy range
-    return 0; // TODO: clean instead? something else?
+    return 0; // Retried, and eventually cleaned, by spray_delete_min()
 
   while (cur->deleted && cur->next[0]) {
     cur = (sl_node_t*)unset_mark((uintptr_t)cur->next[0]); // Find first non-deleted node
@@ -154,16 +232,73 @@ int spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
   }
   if (result != 0) {
     d->nb_collisions++;  
-    return 0; // TODO: Retry and eventually 'clean'
+    return 0; // Retried by spray_delete_min()
   }
 
   *val = (cur->val);
   mark_node_ptrs(cur);
+  sl_size_add(set, -1);
 
   // if (((*seed) & 0x10)) return 1;  
 
-  // TODO: batch deletes (this method is somewhat inefficient)
-  // fraser_search(set, cur->val, NULL, NULL);
+  _spray_unlink(set, d, n, cur->val);
 
   return 1; 
 }
+
+/* Nodes are traversed and unlinked within a critical region, so that the
+ * epoch GC does not free them under our feet. */
+int naive_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
+  int result;
+
+  critical_enter();
+  result = _naive_delete_min(set, val, d);
+  critical_exit();
+
+  return result;
+}
+
+/* A spray which collides, or ends in the dummy range, is retried with a
+ * new spray. After SL_SPRAY_RETRIES failures we fall back to a naive
+ * delete_min, which only fails on an empty set. */
+int spray_delete_min(sl_intset_t *set, val_t *val, thread_data_t *d) {
+  int result = 0;
+  int retries;
+
+  if (d->spray_set != set)
+    spray_join(set, d);
+
+  critical_enter();
+  for (retries = 0; retries < SL_SPRAY_RETRIES; retries++) {
+    if ((result = _spray_delete_min(set, val, d)) != 0)
+      break;
+  }
+  if (result == 0) {
+    d->nb_clean++;
+    result = _naive_delete_min(set, val, d);
+  }
+  d->spray_retries[retries]++;
+  critical_exit();
+
+  return result;
+}
+
+/* Count the thread of d among the live threads of set, see sl_spray_t. */
+void spray_join(sl_intset_t *set, thread_data_t *d) {
+  if (d->spray_set == set)
+    return;
+  if (d->spray_set != NULL)
+    spray_leave(d->spray_set, d);
+
+  __sync_fetch_and_add(&set->threads, 1);
+  d->spray_set = set;
+}
+
+/* To be called by threads which stop deleting, e.g. when they exit. */
+void spray_leave(sl_intset_t *set, thread_data_t *d) {
+  if (d->spray_set != set)
+    return;
+
+  __sync_fetch_and_sub(&set->threads, 1);
+  d->spray_set = NULL;
+}
@@ -25,6 +25,74 @@
 
 ALIGNED(64) uint8_t levelmax[64];
 
+/* Epoch GC hook through which unlinked nodes are freed. */
+static int sl_node_hook = -1;
+
+
+/*
+ * Memory for a node of toplevel levels. Nodes come from the node
+ * allocator if one is installed (see gc/alloc.h). Sentinels always come
+ * from the slabs, as the set may be created before an allocator is
+ * installed.
+ */
+static sl_node_t *
+sl_alloc_node(int toplevel, int sentinel)
+{
+  if (node_allocator != NULL && !sentinel)
+    return (sl_node_t *)node_allocator->alloc(offsetof(sl_node_t, next) + toplevel * sizeof(sl_node_t *));
+
+#ifdef SL_MALLOC_NODES
+  /* use *levelmax instead of toplevel in order to be able to use the ssalloc allocator*/
+  size_t ns = sizeof(sl_node_t) + *levelmax * sizeof(sl_node_t *);
+  size_t ns_rm = ns % 64;
+  if (ns_rm)
+    {
+      ns += 64 - ns_rm;
+    }
+  return (sl_node_t *)ssalloc_alloc(1, ns);
+#else
+  /* Only the levels in use, the slab rounds up to cache lines */
+  return (sl_node_t *)slab_alloc(offsetof(sl_node_t, next) + toplevel * sizeof(sl_node_t *));
+#endif
+}
+
+static void
+sl_free_node(sl_node_t *n, int sentinel)
+{
+  if (node_allocator != NULL && !sentinel)
+    {
+      node_allocator->free(n);
+      return;
+    }
+
+  /* free(n); */
+#ifdef SL_MALLOC_NODES
+  ssfree_alloc(1, n);
+#else
+  slab_free(n);
+#endif
+}
+
+static void
+sl_init_node(sl_node_t *node, val_t val, int toplevel)
+{
+  if (node == NULL)
+    {
+      perror("malloc");
+      exit(1);
+    }
+
+  node->val = val;
+  node->toplevel = toplevel;
+  node->deleted = 0;
+  node->linked = toplevel;
+
+  MEM_BARRIER;
+}
+
+/* Size changes of the calling thread not yet added to set->size. */
+static __thread long size_delta = 0;
+
 int
 get_rand_level()
 {
@@ -68,28 +136,10 @@ sl_new_simple_node(val_t val, int toplevel, int transactional)
     {
       /* node = (sl_node_t *)malloc(sizeof(sl_node_t) + toplevel * sizeof(sl_node_t *)); */
       /* node = (sl_node_t *)ssalloc_alloc(1, sizeof(sl_node_t) + toplevel * sizeof(sl_node_t *)); */
-
-      /* use *levelmax instead of toplevel in order to be able to use the ssalloc allocator*/
-      size_t ns = sizeof(sl_node_t) + *levelmax * sizeof(sl_node_t *);
-      size_t ns_rm = ns % 64;
-      if (ns_rm)
-	{
-	  ns += 64 - ns_rm;
-	}
-      node = (sl_node_t *)ssalloc_alloc(1, ns);
+      node = sl_alloc_node(toplevel, 0);
     }
 
-  if (node == NULL)
-    {
-      perror("malloc");
-      exit(1);
-    }
-
-  node->val = val;
-  node->toplevel = toplevel;
-  node->deleted = 0;
-
-  MEM_BARRIER;
+  sl_init_node(node, val, toplevel);
 
   return node;
 }
@@ -106,7 +156,7 @@ sl_new_node(val_t val, sl_node_t *next, int toplevel, int transactional)
 
   node = sl_new_simple_node(val, toplevel, transactional);
 
-  for (i = 0; i < *levelmax; i++)
+  for (i = 0; i < toplevel; i++)
     node->next[i] = next;
 	
   MEM_BARRIER;
@@ -117,8 +167,42 @@ sl_new_node(val_t val, sl_node_t *next, int toplevel, int transactional)
 void
 sl_delete_node(sl_node_t *n)
 {
-  /* free(n); */
-  ssfree_alloc(1, n);
+  sl_free_node(n, 0);
+}
+
+/* A sentinel spanning all levels the list may ever grow to. */
+static sl_node_t *
+sl_new_sentinel(val_t val, sl_node_t *next)
+{
+  sl_node_t *node = sl_alloc_node(SL_MAX_LEVELS, 1);
+  int i;
+
+  sl_init_node(node, val, SL_MAX_LEVELS);
+  for (i = 0; i < SL_MAX_LEVELS; i++)
+    node->next[i] = next;
+
+  MEM_BARRIER;
+
+  return node;
+}
+
+static void
+sl_free_unlinked(ptst_t *ptst, void *n)
+{
+  sl_delete_node((sl_node_t *)n);
+}
+
+/*
+ * Account for a node having been unlinked from some of its levels, or
+ * for levels it will never be linked into. Whoever drops the last level
+ * retires the node, which is freed once all threads have left their
+ * current critical regions. Must be called within a critical region.
+ */
+void
+sl_unlink_levels(sl_node_t *n, int levels)
+{
+  if (__sync_sub_and_fetch(&n->linked, levels) == 0)
+    gc_add_ptr_to_hook_list(ptst, n, sl_node_hook);
 }
 
 sl_intset_t*
@@ -137,9 +221,22 @@ sl_set_new()
 
   ssalloc_align_alloc(1);
 
-  max = sl_new_node(VAL_MAX, NULL, *levelmax, 0);
-  min = sl_new_node(VAL_MIN, max, *levelmax, 0);
+  if (sl_node_hook < 0)
+    {
+      _init_gc_subsystem();
+      sl_node_hook = gc_add_hook(sl_free_unlinked);
+    }
+
+  max = sl_new_sentinel(VAL_MAX, NULL);
+  min = sl_new_sentinel(VAL_MIN, max);
   set->head = min;
+  set->size = 0;
+  set->threads = 0;
+  set->dead = 0;
+  set->dead_max = 0;
+
+  memset(&set->spray, 0, sizeof(set->spray));
+  set->spray.scanskip = 1;
   return set;
 }
 
@@ -152,7 +249,7 @@ sl_set_delete(sl_intset_t *set)
   while (node != NULL)
     {
       next = (sl_node_t *)((uintptr_t)(node->next[0]) & ~(uintptr_t)0x01);
-      sl_delete_node(node);
+      sl_free_node(node, node == set->head || next == NULL);
       node = next;
     }
   ssfree_alloc(1, set);
@@ -174,3 +271,28 @@ sl_set_size(sl_intset_t *set)
 
   return size;
 }
+
+/*
+ * Account for inserted (delta > 0) or deleted elements. The height of
+ * the list follows log2 of its size as it grows, but never shrinks.
+ * Levels above the current height only link the head to the tail, so
+ * operations pick up a new level as soon as they read it.
+ */
+void
+sl_size_add(sl_intset_t *set, int delta)
+{
+  long size;
+  int h;
+
+  size_delta += delta;
+  if (size_delta < SL_SIZE_BATCH && size_delta > -SL_SIZE_BATCH)
+    return;
+
+  size = __sync_add_and_fetch(&set->size, size_delta);
+  size_delta = 0;
+  if (size <= 0)
+    return;
+
+  while ((h = *levelmax) < SL_MAX_LEVELS && floor_log_2(size) > h)
+    __sync_bool_compare_and_swap(levelmax, h, h + 1);
+}
@@ -37,8 +37,12 @@
 
 #include "tm.h"
 #include "ssalloc.h"
+#include "slab.h"
 #include "utils.h"
 
+#include "gc/alloc.h"
+#include "gc/ptst.h"
+
 #define DEFAULT_DURATION                1000
 #define DEFAULT_INITIAL                 1024
 #define DEFAULT_NB_THREADS              1
@@ -53,6 +57,11 @@
 #define DEFAULT_LIN                     0
 #define DEFAULT_EFFECTIVE               1
 
+/* Levels the list may grow to; the head and tail always have all of them. */
+#define SL_MAX_LEVELS                   32
+/* Size changes a thread accumulates before publishing them. */
+#define SL_SIZE_BATCH                   64
+
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
 
@@ -71,12 +80,47 @@ typedef ALIGNED(64) struct sl_node
   
   int toplevel;
   intptr_t deleted;
-  struct sl_node *next[19];
+  /* Levels the node is still linked into, or may yet be linked into. */
+  intptr_t linked;
+  struct sl_node *next[SL_MAX_LEVELS];
 } sl_node_t;
 
+/* Sprayed deletes per thread after which the dead prefix is unlinked. */
+#define SL_SPRAY_DEAD                   8
+/* Sprayed deletes a thread accumulates before publishing them. */
+#define SL_SPRAY_DEAD_BATCH             8
+
+/* Sprays a delete_min makes before it falls back to a naive delete_min. */
+#define SL_SPRAY_RETRIES                4
+
+/*
+ * Spray parameters of a set, see spray_delete_min() in pqueue.c. A zero
+ * height, scanmax or clean selects the default, derived from the number
+ * of threads.
+ */
+typedef struct sl_spray
+{
+  int height;   /* Level the spray starts at */
+  int scanmax;  /* Maximum jump length at the top level */
+  int scaninc;  /* Jump length increase at each step down */
+  int scanskip; /* Levels to go down at each step, > 0 */
+  int clean;    /* 1 in clean deletes is a naive delete_min */
+  int adaptive; /* Adapt the jump length to collisions and live threads */
+} sl_spray_t;
+
 typedef ALIGNED(64) struct sl_intset
 {
   sl_node_t *head;
+  sl_spray_t spray;
+  /* Threads deleting from the set, see spray_join() */
+  long threads;
+  /* Approximate number of elements, see sl_size_add(). Kept off the
+   * line of the head pointer, which every operation reads. */
+  long size ALIGNED(64);
+  /* Sprayed deletes not yet unlinked, and the largest of their keys, see
+   * spray_delete_min() */
+  long dead;
+  val_t dead_max;
 } sl_intset_t;
 
 int get_rand_level();
@@ -85,9 +129,11 @@ int floor_log_2(unsigned int n);
 sl_node_t *sl_new_simple_node(val_t val, int toplevel, int transactional);
 sl_node_t *sl_new_node(val_t val, sl_node_t *next, int toplevel, int transactional);
 void sl_delete_node(sl_node_t *n);
+void sl_unlink_levels(sl_node_t *n, int levels);
 
 sl_intset_t *sl_set_new();
 void sl_set_delete(sl_intset_t *set);
 int sl_set_size(sl_intset_t *set);
+void sl_size_add(sl_intset_t *set, int delta);
 
 inline long rand_range(long r); /* declared in test.c */
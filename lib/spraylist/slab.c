@@ -0,0 +1,231 @@
+/*
+ * File:
+ *   slab.c
+ * Description:
+ *   Per-thread slab allocator for skip list nodes, see slab.h.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slab.h"
+
+typedef struct slab_obj
+{
+  struct slab_obj *next;
+} slab_obj_t;
+
+typedef struct slab_heap slab_heap_t;
+
+/* Remote frees of a single class, all owned by the same heap. */
+typedef struct slab_batch
+{
+  slab_heap_t *owner;
+  slab_obj_t *head;
+  slab_obj_t *tail;
+  int n;
+} slab_batch_t;
+
+struct slab_heap
+{
+  /* Pushed to by other threads, taken as a whole by the owner. */
+  slab_obj_t *remote[SLAB_CLASSES] __attribute__((aligned(SLAB_LINE)));
+
+  /* Private to the owner. */
+  slab_obj_t *local[SLAB_CLASSES] __attribute__((aligned(SLAB_LINE)));
+  char *bump[SLAB_CLASSES];
+  char *end[SLAB_CLASSES];
+  slab_batch_t batch[SLAB_CLASSES];
+
+  int in_use;
+  slab_heap_t *next;
+};
+
+/* Lives in the first cache line of every slab. */
+typedef struct slab
+{
+  slab_heap_t *owner;
+  int cls;
+} slab_t;
+
+static slab_heap_t *heap_list = NULL;
+static __thread slab_heap_t *heap = NULL;
+
+static pthread_key_t heap_key;
+static pthread_once_t heap_key_once = PTHREAD_ONCE_INIT;
+
+static void
+batch_flush(slab_batch_t *b, int cls)
+{
+  slab_obj_t *head;
+
+  if (b->n == 0)
+    return;
+
+  do
+    {
+      head = b->owner->remote[cls];
+      b->tail->next = head;
+    }
+  while (!__sync_bool_compare_and_swap(&b->owner->remote[cls], head, b->head));
+
+  b->owner = NULL;
+  b->head = b->tail = NULL;
+  b->n = 0;
+}
+
+/* A heap outlives its thread: it still owns the slabs it carved. */
+static void
+heap_release(void *h)
+{
+  slab_flush();
+  __sync_synchronize();
+  ((slab_heap_t *)h)->in_use = 0;
+  heap = NULL;
+}
+
+static void
+heap_key_init(void)
+{
+  pthread_key_create(&heap_key, heap_release);
+}
+
+static slab_heap_t *
+heap_get(void)
+{
+  slab_heap_t *h, *next;
+  void *mem;
+
+  if (heap != NULL)
+    return heap;
+
+  pthread_once(&heap_key_once, heap_key_init);
+
+  /* Adopt the heap of an exited thread, if any. */
+  for (h = heap_list; h != NULL; h = h->next)
+    {
+      if (!h->in_use && __sync_bool_compare_and_swap(&h->in_use, 0, 1))
+        goto out;
+    }
+
+  if (posix_memalign(&mem, SLAB_LINE, sizeof(slab_heap_t)) != 0)
+    {
+      perror("posix_memalign");
+      exit(1);
+    }
+  h = (slab_heap_t *)mem;
+  memset(h, 0, sizeof(slab_heap_t));
+  h->in_use = 1;
+
+  do
+    {
+      next = heap_list;
+      h->next = next;
+    }
+  while (!__sync_bool_compare_and_swap(&heap_list, next, h));
+
+out:
+  heap = h;
+  pthread_setspecific(heap_key, h);
+  return h;
+}
+
+static void
+slab_refill(slab_heap_t *h, int cls)
+{
+  slab_t *s;
+  void *mem;
+
+  if (posix_memalign(&mem, SLAB_SIZE, SLAB_SIZE) != 0)
+    {
+      perror("posix_memalign");
+      exit(1);
+    }
+
+  s = (slab_t *)mem;
+  s->owner = h;
+  s->cls = cls;
+
+  h->bump[cls] = (char *)mem + SLAB_LINE;
+  h->end[cls] = (char *)mem + SLAB_SIZE;
+}
+
+void *
+slab_alloc(size_t size)
+{
+  slab_heap_t *h = heap_get();
+  const int cls = (size + SLAB_LINE - 1) / SLAB_LINE - 1;
+  const size_t osize = (cls + 1) * SLAB_LINE;
+  slab_obj_t *o;
+  char *p;
+
+  assert(size > 0 && size <= SLAB_MAX_OBJECT);
+
+  if ((o = h->local[cls]) != NULL)
+    {
+      h->local[cls] = o->next;
+      return o;
+    }
+
+  /* Take back everything other threads freed meanwhile. */
+  if (h->remote[cls] != NULL &&
+      (o = __sync_lock_test_and_set(&h->remote[cls], NULL)) != NULL)
+    {
+      h->local[cls] = o->next;
+      return o;
+    }
+
+  if (h->bump[cls] + osize > h->end[cls])
+    slab_refill(h, cls);
+
+  p = h->bump[cls];
+  h->bump[cls] += osize;
+  return p;
+}
+
+void
+slab_free(void *p)
+{
+  slab_heap_t *h = heap_get();
+  slab_t *s = (slab_t *)((uintptr_t)p & ~(SLAB_SIZE - 1));
+  slab_obj_t *o = (slab_obj_t *)p;
+  slab_batch_t *b;
+
+  if (s->owner == h)
+    {
+      o->next = h->local[s->cls];
+      h->local[s->cls] = o;
+      return;
+    }
+
+  b = &h->batch[s->cls];
+  if (b->owner != s->owner)
+    {
+      batch_flush(b, s->cls);
+      b->owner = s->owner;
+    }
+
+  o->next = b->head;
+  if (b->head == NULL)
+    b->tail = o;
+  b->head = o;
+
+  if (++b->n == SLAB_BATCH)
+    batch_flush(b, s->cls);
+}
+
+void
+slab_flush(void)
+{
+  int i;
+
+  if (heap == NULL)
+    return;
+
+  for (i = 0; i < SLAB_CLASSES; i++)
+    batch_flush(&heap->batch[i], i);
+}
@@ -0,0 +1,37 @@
+/*
+ * File:
+ *   slab.h
+ * Description:
+ *   Per-thread slab allocator for skip list nodes.
+ *
+ *   Every thread allocates from its own slabs, one size class per number
+ *   of cache lines, so nodes of similar toplevel share slabs and all
+ *   nodes are cache line aligned. Memory freed by the owning thread goes
+ *   back onto its local free lists. Memory freed by other threads (e.g.
+ *   reclaimed by the epoch GC on another thread) is collected in small
+ *   per-thread batches and handed back to the owner with a single CAS per
+ *   batch. Slabs are allocated on demand, so the allocator grows without
+ *   bound. The heaps of exited threads are adopted by new threads.
+ */
+
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <stddef.h>
+
+/* Size of a slab, slabs are aligned to their size. */
+#define SLAB_SIZE                       (64UL << 10)
+#define SLAB_LINE                       64
+/* Objects of up to SLAB_CLASSES cache lines. */
+#define SLAB_CLASSES                    8
+#define SLAB_MAX_OBJECT                 (SLAB_CLASSES * SLAB_LINE)
+/* Remote frees handed back to the owner at once. */
+#define SLAB_BATCH                      32
+
+void *slab_alloc(size_t size);
+void slab_free(void *p);
+
+/* Hand back the calling thread's pending remote frees. */
+void slab_flush(void);
+
+#endif // SLAB_H_
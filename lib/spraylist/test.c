@@ -394,7 +394,7 @@ int main(int argc, char **argv)
 
   sl_intset_t *set;
   pq_t *linden_set;
-  int i, c, size;
+  int i, j, c, size;
   val_t last = 0; 
   val_t val = 0;
   pval_t pval = 0;
@@ -702,6 +702,13 @@ int main(int argc, char **argv)
     data[i].nb_collisions = 0;
     data[i].nb_add = 0;
     data[i].nb_clean = 0;
+    data[i].spray_set = NULL;
+    data[i].spray_width = 0;
+    data[i].spray_ops = 0;
+    data[i].spray_collisions = 0;
+    data[i].spray_misses = 0;
+    data[i].spray_dead = 0;
+    memset(data[i].spray_retries, 0, sizeof(data[i].spray_retries));
     data[i].nb_added = 0;
     data[i].nb_remove = 0;
     data[i].nb_removed = 0;
@@ -809,6 +816,10 @@ int main(int argc, char **argv)
     printf("    #cleaned  : %lu\n", data[i].nb_clean);
     printf("first remove  : %d\n", data[i].first_remove);
     printf(" #collisions  : %lu\n", data[i].nb_collisions);
+    printf("  #retries    :");
+    for (j = 0; j <= SL_SPRAY_RETRIES; j++)
+      printf(" %lu", data[i].spray_retries[j]);
+    printf("\n");
     printf("  #contains   : %lu\n", data[i].nb_contains);
     printf("  #found      : %lu\n", data[i].nb_found);
     printf("  #aborts     : %lu\n", data[i].nb_aborts);
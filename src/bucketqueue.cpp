@@ -0,0 +1,167 @@
+#include "bucketqueue.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static constexpr size_t WORD_BITS = 64;
+
+static void *
+aligned_calloc(const size_t size)
+{
+    void *mem;
+    if (posix_memalign(&mem, CACHE_LINE_SIZE, size) != 0) {
+        abort();
+    }
+    memset(mem, 0, size);
+    return mem;
+}
+
+BucketQueue::BucketQueue(const uint32_t max_key,
+                         const int shift) :
+    m_shift(shift),
+    m_nbuckets((max_key >> shift) + 1),
+    m_nwords((m_nbuckets + WORD_BITS - 1) / WORD_BITS),
+    m_cur(0)
+{
+    m_buckets = static_cast<bucket_t *>(
+            aligned_calloc(m_nbuckets * sizeof(bucket_t)));
+    m_bitmap = static_cast<std::atomic<uint64_t> *>(
+            aligned_calloc(m_nwords * sizeof(std::atomic<uint64_t>)));
+
+    m_cur.store(m_nbuckets);
+}
+
+BucketQueue::~BucketQueue()
+{
+    /* Nodes belong to the GC pools and are released with them. */
+    free(m_bitmap);
+    free(m_buckets);
+}
+
+size_t
+BucketQueue::find_bucket(const size_t b) const
+{
+    if (b >= m_nbuckets) {
+        return m_nbuckets;
+    }
+
+    size_t w = b / WORD_BITS;
+    uint64_t word = m_bitmap[w].load() & (~0ULL << (b % WORD_BITS));
+    while (word == 0) {
+        if (++w == m_nwords) {
+            return m_nbuckets;
+        }
+        word = m_bitmap[w].load();
+    }
+
+    return w * WORD_BITS + __builtin_ctzll(word);
+}
+
+void
+BucketQueue::lower_cur(const size_t b)
+{
+    size_t c = m_cur.load();
+    while (b < c && !m_cur.compare_exchange_weak(c, b)) {
+        /* Retry. */;
+    }
+}
+
+void
+BucketQueue::advance_cur(const size_t from,
+                         const size_t to)
+{
+    size_t c = from;
+    if (!m_cur.compare_exchange_strong(c, to)) {
+        return;
+    }
+
+    /* An insert into [from, to) which read the index before our CAS did
+     * not lower it. Recheck the skipped buckets and undo if necessary. */
+    const size_t b = find_bucket(from);
+    if (b < to) {
+        lower_cur(b);
+    }
+}
+
+void
+BucketQueue::insert(const uint32_t v)
+{
+    size_t b = v >> m_shift;
+    if (b >= m_nbuckets) {
+        b = m_nbuckets - 1;
+    }
+
+    {
+        epoch::guard g;
+
+        node_t *n = m_nodes.alloc();
+        n->v = v;
+
+        std::atomic<node_t *> &head = m_buckets[b].head;
+        node_t *h = head.load(std::memory_order_relaxed);
+        do {
+            n->next = h;
+        } while (!head.compare_exchange_weak(h, n));
+    }
+
+    /* The bitmap word is shared by 64 buckets, avoid writing it if
+     * possible. A concurrent clear rechecks the bucket after clearing. */
+    std::atomic<uint64_t> &word = m_bitmap[b / WORD_BITS];
+    const uint64_t bit = 1ULL << (b % WORD_BITS);
+    if ((word.load() & bit) == 0) {
+        word.fetch_or(bit);
+    }
+
+    /* Must happen after the push: a concurrent delete_min which found
+     * the bucket empty and advanced past it is undone here. */
+    lower_cur(b);
+}
+
+bool
+BucketQueue::delete_min(uint32_t &v)
+{
+    bool found = false;
+
+    epoch::guard g;
+
+    while (true) {
+        /* Locate the first non-empty bucket without writing anything;
+         * the index is moved at most once per scan. */
+        const size_t c = m_cur.load();
+        const size_t b = find_bucket(c);
+
+        if (b != c) {
+            advance_cur(c, b);
+        }
+
+        if (b == m_nbuckets) {
+            break;
+        }
+
+        /* The epoch protects h from being recycled while we hold it,
+         * which rules out ABA on the head CAS. */
+        std::atomic<node_t *> &head = m_buckets[b].head;
+        node_t *h = head.load();
+        while (h != nullptr && !head.compare_exchange_weak(h, h->next)) {
+            /* Retry. */;
+        }
+
+        if (h != nullptr) {
+            v = h->v;
+            m_nodes.retire(h);
+            found = true;
+            break;
+        }
+
+        /* The bucket has run empty. Clear its bit, and restore it if an
+         * insert raced with us. */
+        std::atomic<uint64_t> &word = m_bitmap[b / WORD_BITS];
+        const uint64_t bit = 1ULL << (b % WORD_BITS);
+        word.fetch_and(~bit);
+        if (head.load() != nullptr) {
+            word.fetch_or(bit);
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,67 @@
+#ifndef __BUCKETQUEUE_H
+#define __BUCKETQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "gc/epoch.h"
+
+/**
+ * A concurrent bucket queue for bounded integer keys.
+ *
+ * The key range [0, max_key] is split into buckets of width 2^shift, each
+ * of which is a lock-free bag (a Treiber stack whose nodes are recycled
+ * through Fraser's epoch GC). A bitmap summarizes which buckets are
+ * non-empty, and an atomic index points at the lowest bucket that may
+ * contain elements. delete_min() is exact up to the bucket width: keys
+ * sharing a bucket are returned in arbitrary order. Keys larger than
+ * max_key are placed in the last bucket.
+ *
+ * The structure is intended for monotone workloads (Dijkstra, discrete
+ * event simulation), in which most operations touch only the few buckets
+ * at the current minimum.
+ */
+class BucketQueue
+{
+public:
+    BucketQueue(const uint32_t max_key,
+                const int shift);
+    virtual ~BucketQueue();
+
+    void insert(const uint32_t v);
+    bool delete_min(uint32_t &v);
+
+private:
+    struct node_t {
+        node_t *next;
+        uint32_t v;
+    };
+
+    struct bucket_t {
+        std::atomic<node_t *> head;
+        char pad[CACHE_LINE_SIZE - sizeof(std::atomic<node_t *>)];
+    };
+
+    size_t find_bucket(const size_t b) const;
+    void lower_cur(const size_t b);
+    void advance_cur(const size_t from,
+                     const size_t to);
+
+private:
+    const int m_shift;
+    const size_t m_nbuckets;
+    const size_t m_nwords;
+
+    bucket_t *m_buckets;
+
+    /** Bit b is set if bucket b may be non-empty. */
+    std::atomic<uint64_t> *m_bitmap;
+
+    /** Lowest bucket which may contain elements. */
+    std::atomic<size_t> m_cur;
+
+    epoch::pool<node_t> m_nodes;
+};
+
+#endif /* __BUCKETQUEUE_H */
@@ -0,0 +1,125 @@
+#ifndef __BUFFERED_H
+#define __BUFFERED_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Thread-local insertion buffers in front of a concurrent priority queue.
+ *
+ * Each thread keeps up to capacity inserted keys in a small sorted buffer.
+ * Keys which are competitive, i.e. not larger than the cached head minimum
+ * of the shared queue, bypass the buffer. The buffer is flushed into the
+ * shared queue when it is full, or once its own minimum has become
+ * competitive. delete_min() returns the buffer's head instead of touching
+ * the shared queue whenever it is competitive.
+ *
+ * Buffered keys are invisible to other threads, so delete_min is relaxed
+ * by at most capacity keys per thread. Threads must flush() before they
+ * stop operating on the queue. PQ must provide insert_sorted() taking
+ * keys in ascending order. Buffers are per thread and per queue type,
+ * so only a single instance may exist per PQ.
+ */
+template <typename PQ>
+class Buffered
+{
+public:
+    static constexpr size_t MAX_CAPACITY = 64;
+
+    Buffered(PQ &q,
+             const size_t capacity) :
+        m_q(q),
+        m_capacity(capacity < MAX_CAPACITY ? capacity : MAX_CAPACITY)
+    {
+        m_min.store(0);
+    }
+
+    void insert(const uint32_t v)
+    {
+        buffer_t &b = m_buffer;
+        const uint32_t min = m_min.load(std::memory_order_relaxed);
+
+        if (v <= min || m_capacity == 0) {
+            m_q.insert(v);
+            return;
+        }
+
+        if (b.n == m_capacity) {
+            flush();
+        }
+
+        /* Keys are kept in descending order, the minimum is last. */
+        size_t i = b.n++;
+        while (i > 0 && b.keys[i - 1] < v) {
+            b.keys[i] = b.keys[i - 1];
+            i--;
+        }
+        b.keys[i] = v;
+
+        if (b.keys[b.n - 1] <= min) {
+            flush();
+        }
+    }
+
+    bool delete_min(uint32_t &v)
+    {
+        buffer_t &b = m_buffer;
+
+        if (b.n > 0 && b.keys[b.n - 1] <= m_min.load(std::memory_order_relaxed)) {
+            v = b.keys[--b.n];
+            return true;
+        }
+
+        if (m_q.delete_min(v)) {
+            if (m_min.load(std::memory_order_relaxed) != v) {
+                m_min.store(v, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        if (b.n > 0) {
+            v = b.keys[--b.n];
+            return true;
+        }
+
+        return false;
+    }
+
+    /** Moves all keys buffered by the calling thread into the queue. */
+    void flush()
+    {
+        buffer_t &b = m_buffer;
+
+        /* Smallest first, so that competitive keys become visible early,
+         * and each insert can start where the previous one ended. */
+        for (size_t i = 0, j = b.n; i + 1 < j; i++, j--) {
+            const uint32_t k = b.keys[i];
+            b.keys[i] = b.keys[j - 1];
+            b.keys[j - 1] = k;
+        }
+        m_q.insert_sorted(b.keys, b.n);
+        b.n = 0;
+    }
+
+private:
+    struct buffer_t {
+        size_t n;
+        uint32_t keys[MAX_CAPACITY];
+    };
+
+private:
+    PQ &m_q;
+    const size_t m_capacity;
+
+    /** Key last returned by the shared queue. */
+    std::atomic<uint32_t> m_min __attribute__((aligned(CACHE_LINE_SIZE)));
+    char m_pad[CACHE_LINE_SIZE];
+
+    static __thread buffer_t m_buffer;
+};
+
+template <typename PQ>
+__thread typename Buffered<PQ>::buffer_t Buffered<PQ>::m_buffer;
+
+#endif /* __BUFFERED_H */
@@ -0,0 +1,45 @@
+#include "cachemisses.h"
+
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+CacheMisses::CacheMisses()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    m_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+CacheMisses::~CacheMisses()
+{
+    if (valid()) {
+        close(m_fd);
+    }
+}
+
+bool
+CacheMisses::valid() const
+{
+    return m_fd >= 0;
+}
+
+uint64_t
+CacheMisses::read() const
+{
+    uint64_t n;
+    if (!valid() || ::read(m_fd, &n, sizeof(n)) != sizeof(n)) {
+        return 0;
+    }
+    return n;
+}
@@ -0,0 +1,25 @@
+#ifndef __CACHEMISSES_H
+#define __CACHEMISSES_H
+
+#include <cstdint>
+
+/**
+ * Counts the L1 data cache read misses of the calling thread in user
+ * space, using a perf event. If the event cannot be opened (no kernel
+ * support, or a too restrictive perf_event_paranoid), valid() is false
+ * and read() returns 0.
+ */
+class CacheMisses
+{
+public:
+    CacheMisses();
+    virtual ~CacheMisses();
+
+    bool valid() const;
+    uint64_t read() const;
+
+private:
+    int m_fd;
+};
+
+#endif /* __CACHEMISSES_H */
@@ -0,0 +1,164 @@
+#include "delegation.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+
+/** Spins before yielding the processor, which is only expected to happen
+ * when clients and servers share cores. */
+static constexpr int SPINS_PER_YIELD = 1 << 10;
+
+static constexpr size_t NO_CLIENT = SIZE_MAX;
+
+static __thread size_t client = NO_CLIENT;
+
+static inline void
+spin(int &spins)
+{
+    if (++spins == SPINS_PER_YIELD) {
+        spins = 0;
+        sched_yield();
+    } else {
+        __builtin_ia32_pause();
+    }
+}
+
+Delegation::Delegation() :
+    m_nclients(0),
+    m_running(true)
+{
+    for (size_t i = 0; i < MAX_CLIENTS; i++) {
+        m_requests[i].seq.store(0);
+        m_served[i] = 0;
+    }
+
+    for (size_t i = 0; i < MAX_GROUPS; i++) {
+        for (size_t j = 0; j < CLIENTS_PER_GROUP; j++) {
+            m_responses[i].ack[j].store(0);
+        }
+    }
+}
+
+size_t
+Delegation::client_id()
+{
+    if (client == NO_CLIENT) {
+        client = m_nclients.fetch_add(1);
+        if (client >= MAX_CLIENTS) {
+            fprintf(stderr, "Delegation: more than %zu clients\n", MAX_CLIENTS);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return client;
+}
+
+bool
+Delegation::delegate(const op_t op,
+                     uint32_t &v)
+{
+    const size_t id = client_id();
+    request_t &req = m_requests[id];
+    response_t &resp = m_responses[id / CLIENTS_PER_GROUP];
+    const size_t slot = id % CLIENTS_PER_GROUP;
+
+    /* Sequence numbers are 31 bits wide and never 0, the initial state. */
+    uint32_t seq = (req.seq.load(std::memory_order_relaxed) + 1) & (UINT32_MAX >> 1);
+    if (seq == 0) {
+        seq = 1;
+    }
+
+    req.op = op;
+    req.v = v;
+    req.seq.store(seq, std::memory_order_release);
+
+    int spins = 0;
+    uint32_t ack;
+    while (((ack = resp.ack[slot].load(std::memory_order_acquire)) >> 1) != seq) {
+        spin(spins);
+    }
+
+    v = resp.v[slot];
+    return (ack & 1);
+}
+
+void
+Delegation::insert(const uint32_t v)
+{
+    uint32_t u = v;
+    delegate(OP_INSERT, u);
+}
+
+bool
+Delegation::delete_min(uint32_t &v)
+{
+    return delegate(OP_DELETE_MIN, v);
+}
+
+void
+Delegation::serve(const size_t server,
+                  const size_t nservers)
+{
+    int spins = 0;
+    while (m_running.load(std::memory_order_relaxed)) {
+        const size_t ngroups =
+            (m_nclients.load(std::memory_order_relaxed) + CLIENTS_PER_GROUP - 1) / CLIENTS_PER_GROUP;
+
+        bool served = false;
+        for (size_t g = server; g < ngroups && g < MAX_GROUPS; g += nservers) {
+            response_t &resp = m_responses[g];
+            uint32_t acks[CLIENTS_PER_GROUP];
+            size_t nacks = 0;
+
+            /* Execute all pending requests of the group, then publish
+             * the results together so the response line moves once. */
+            for (size_t i = 0; i < CLIENTS_PER_GROUP; i++) {
+                const size_t id = g * CLIENTS_PER_GROUP + i;
+                request_t &req = m_requests[id];
+
+                const uint32_t seq = req.seq.load(std::memory_order_acquire);
+                if (seq == m_served[id]) {
+                    acks[i] = 0;
+                    continue;
+                }
+
+                bool ok = true;
+                uint32_t v = req.v;
+                switch (req.op) {
+                case OP_INSERT: m_q.insert(v); break;
+                case OP_DELETE_MIN: ok = m_q.delete_min(v); break;
+                default: assert(0);
+                }
+
+                m_served[id] = seq;
+                resp.v[i] = v;
+                acks[i] = (seq << 1) | ok;
+                nacks++;
+            }
+
+            if (nacks == 0) {
+                continue;
+            }
+
+            for (size_t i = 0; i < CLIENTS_PER_GROUP; i++) {
+                if (acks[i] != 0) {
+                    resp.ack[i].store(acks[i], std::memory_order_release);
+                }
+            }
+            served = true;
+        }
+
+        if (served) {
+            spins = 0;
+        } else {
+            spin(spins);
+        }
+    }
+}
+
+void
+Delegation::stop()
+{
+    m_running.store(false);
+}
@@ -0,0 +1,81 @@
+#ifndef __DELEGATION_H
+#define __DELEGATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "globallock.h"
+
+/**
+ * A delegation-based priority queue in the style of ffwd.
+ *
+ * One or more dedicated server threads own a sequential heap (the GlobalLock
+ * queue, whose mutex is then only ever taken by the servers). Clients post
+ * requests into a private cache line and spin on a response line that is
+ * shared by a group of CLIENTS_PER_GROUP clients. A server serves whole
+ * groups at a time and writes back all of a group's responses at once.
+ *
+ * Clients are registered implicitly on their first operation. Server threads
+ * are provided by the user and enter the queue through serve(); at least
+ * one server must be running while clients operate on the queue. Only a
+ * single instance may exist per process.
+ */
+class Delegation
+{
+public:
+    Delegation();
+
+    void insert(const uint32_t v);
+    bool delete_min(uint32_t &v);
+
+    /**
+     * Serves requests until stop() is called. The groups of clients are
+     * distributed round-robin over the nservers servers.
+     */
+    void serve(const size_t server,
+               const size_t nservers);
+    void stop();
+
+private:
+    static constexpr size_t MAX_CLIENTS = 256;
+    static constexpr size_t CLIENTS_PER_GROUP = 8;
+    static constexpr size_t MAX_GROUPS = MAX_CLIENTS / CLIENTS_PER_GROUP;
+
+    enum op_t {
+        OP_INSERT,
+        OP_DELETE_MIN,
+    };
+
+    /** Written by a single client, read by its server. */
+    struct __attribute__((aligned(CACHE_LINE_SIZE))) request_t {
+        std::atomic<uint32_t> seq;
+        uint32_t op;
+        uint32_t v;
+    };
+
+    /** Written by a single server, read by the clients of a group.
+     * ack is (seq << 1) | success. */
+    struct __attribute__((aligned(CACHE_LINE_SIZE))) response_t {
+        uint32_t v[CLIENTS_PER_GROUP];
+        std::atomic<uint32_t> ack[CLIENTS_PER_GROUP];
+    };
+
+    size_t client_id();
+    bool delegate(const op_t op,
+                  uint32_t &v);
+
+private:
+    GlobalLock m_q;
+
+    std::atomic<size_t> m_nclients;
+    std::atomic<bool> m_running;
+
+    request_t m_requests[MAX_CLIENTS];
+    response_t m_responses[MAX_GROUPS];
+
+    /** Last request served per client, private to the owning server. */
+    uint32_t m_served[MAX_CLIENTS];
+};
+
+#endif /* __DELEGATION_H */
@@ -0,0 +1,178 @@
+#ifndef __ELIMINATION_H
+#define __ELIMINATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * An elimination front-end for a concurrent priority queue.
+ *
+ * An insert whose key is not larger than the cached head minimum is posted
+ * into a randomly chosen exchange slot and waits there for a bounded
+ * number of spins. A delete_min which finds a posted key no larger than
+ * the cached minimum takes it, and the pair completes without touching the
+ * underlying queue. Everything else falls through to the underlying queue.
+ *
+ * The cached minimum is the key last returned by the underlying queue, and
+ * is only a hint: eliminated keys may exceed the true minimum by however
+ * far the queue head has moved since.
+ */
+template <typename PQ>
+class Elimination
+{
+public:
+    Elimination(PQ &q,
+                const size_t nslots = DEFAULT_SLOTS) :
+        m_q(q),
+        m_nslots(nslots)
+    {
+        void *mem;
+        if (posix_memalign(&mem, CACHE_LINE_SIZE, nslots * sizeof(slot_t)) != 0) {
+            abort();
+        }
+        m_slots = static_cast<slot_t *>(mem);
+
+        m_min.store(0);
+        for (size_t i = 0; i < m_nslots; i++) {
+            m_slots[i].state.store(EMPTY);
+            m_slots[i].eliminated.store(0);
+            m_slots[i].timeouts.store(0);
+        }
+    }
+
+    virtual ~Elimination()
+    {
+        free(m_slots);
+    }
+
+    void insert(const uint32_t v)
+    {
+        if (v <= m_min.load(std::memory_order_relaxed) && try_post(v)) {
+            return;
+        }
+
+        m_q.insert(v);
+    }
+
+    bool delete_min(uint32_t &v)
+    {
+        if (try_take(v)) {
+            return true;
+        }
+
+        if (!m_q.delete_min(v)) {
+            return false;
+        }
+
+        if (m_min.load(std::memory_order_relaxed) != v) {
+            m_min.store(v, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    /** Number of insert/delete_min pairs that bypassed the queue. */
+    uint64_t eliminated() const
+    {
+        uint64_t n = 0;
+        for (size_t i = 0; i < m_nslots; i++) {
+            n += m_slots[i].eliminated.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    /** Number of posted inserts that timed out and fell back. */
+    uint64_t timeouts() const
+    {
+        uint64_t n = 0;
+        for (size_t i = 0; i < m_nslots; i++) {
+            n += m_slots[i].timeouts.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+private:
+    static constexpr size_t DEFAULT_SLOTS = 16;
+    static constexpr int SPINS = 128;
+
+    /* Slot states. A posted slot carries its key in the low 32 bits. */
+    static constexpr uint64_t EMPTY  = 0;
+    static constexpr uint64_t POSTED = 1ULL << 32;
+    static constexpr uint64_t TAKEN  = 2ULL << 32;
+
+    /** Counters live on the slot's line, which their writers own anyway. */
+    struct __attribute__((aligned(CACHE_LINE_SIZE))) slot_t {
+        std::atomic<uint64_t> state;
+        std::atomic<uint64_t> eliminated;
+        std::atomic<uint64_t> timeouts;
+    };
+
+    slot_t &random_slot()
+    {
+        static __thread uint32_t seed = 0;
+        if (seed == 0) {
+            seed = (uint32_t)(uintptr_t)&seed | 1;
+        }
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return m_slots[seed % m_nslots];
+    }
+
+    bool try_post(const uint32_t v)
+    {
+        slot_t &s = random_slot();
+
+        uint64_t e = EMPTY;
+        if (!s.state.compare_exchange_strong(e, POSTED | v)) {
+            return false;
+        }
+
+        for (int i = 0; i < SPINS && s.state.load() != TAKEN; i++) {
+            __builtin_ia32_pause();
+        }
+
+        e = POSTED | v;
+        if (s.state.compare_exchange_strong(e, EMPTY)) {
+            s.timeouts.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /* A delete_min took the key and left the slot to us. */
+        s.state.store(EMPTY);
+        return true;
+    }
+
+    bool try_take(uint32_t &v)
+    {
+        slot_t &s = random_slot();
+
+        uint64_t e = s.state.load();
+        if ((e & ~0xffffffffULL) != POSTED ||
+            (uint32_t)e > m_min.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        if (!s.state.compare_exchange_strong(e, TAKEN)) {
+            return false;
+        }
+
+        s.eliminated.fetch_add(1, std::memory_order_relaxed);
+        v = (uint32_t)e;
+        return true;
+    }
+
+private:
+    PQ &m_q;
+
+    const size_t m_nslots;
+    slot_t *m_slots;
+
+    /** Key last returned by the underlying queue. */
+    std::atomic<uint32_t> m_min __attribute__((aligned(CACHE_LINE_SIZE)));
+    char m_pad[CACHE_LINE_SIZE];
+};
+
+#endif /* __ELIMINATION_H */
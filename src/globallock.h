@@ -1,8 +1,13 @@
 #ifndef __GLOBALLOCK_H
 #define __GLOBALLOCK_H
 
+#include <cstdint>
+#include <functional>
 #include <mutex>
 #include <queue>
+#include <vector>
+
+#include "nodeallocator.h"
 
 class GlobalLock
 {
@@ -13,7 +18,10 @@ public:
     bool delete_min(uint32_t &v);
 
 private:
-    typedef std::priority_queue<uint32_t> pq_t;
+    /* std::priority_queue is a max-heap by default. */
+    typedef std::priority_queue<uint32_t,
+                                std::vector<uint32_t, NodeAllocator<uint32_t> >,
+                                std::greater<uint32_t> > pq_t;
 
     std::mutex m_mutex;
     pq_t m_q;
@@ -1,6 +1,8 @@
 #include "heap.h"
 
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <random>
 
 Heap::Heap(const size_t capacity) :
@@ -11,7 +13,10 @@ Heap::Heap(const size_t capacity) :
 void
 Heap::insert(const uint32_t v)
 {
-    m_q.push(v);
+    if (!m_q.push(v)) {
+        fprintf(stderr, "Heap: exceeded capacity of %zu\n", m_q.capacity());
+        exit(EXIT_FAILURE);
+    }
 }
 
 bool
@@ -3,6 +3,16 @@
 
 #include "libcds/cds/container/mspriority_queue.h"
 
+extern "C" {
+#include "gc/backoff.h"
+}
+
+/**
+ * The array-based heap of Hunt et al. (libcds MSPriorityQueue). The heap
+ * array is segmented and grows by doubling whenever it is full, starting
+ * at the given capacity. Keys are stored in the nodes, which are padded so
+ * that only siblings share a cache line.
+ */
 class Heap
 {
 public:
@@ -12,15 +22,48 @@ public:
     bool delete_min(uint32_t &v);
 
 private:
+    /**
+     * Backs off following the policy selected with backoff_set_policy(),
+     * or as Default with BACKOFF_NONE. Adaptive delays are learned
+     * separately per Default.
+     */
+    template <typename Default>
+    class policy_backoff
+    {
+    public:
+        void operator()()
+        {
+            switch (backoff_policy) {
+            case BACKOFF_EXPONENTIAL: m_exponential(); break;
+            case BACKOFF_ADAPTIVE: m_adaptive(); break;
+            default: m_default(); break;
+            }
+        }
+
+        void reset()
+        {
+            m_default.reset();
+            m_exponential.reset();
+            m_adaptive.reset();
+        }
+
+    private:
+        Default m_default;
+        cds::backoff::exponential<cds::backoff::pause, cds::backoff::yield> m_exponential;
+        cds::backoff::adaptive<cds::backoff::pause, cds::backoff::yield, Default> m_adaptive;
+    };
+
     struct type_traits {
-        typedef cds::container::opt::v::dynamic_buffer<void *>  buffer      ;
+        typedef cds::container::opt::v::segmented_buffer<void *>  buffer    ;
         typedef cds::container::opt::none           compare     ;
         typedef std::greater<uint32_t>        less        ; /* We need a min-heap. */
-        typedef cds::lock::Spin          lock_type   ;
-        typedef cds::backoff::yield      back_off    ;
+        typedef cds::lock::Spinlock<policy_backoff<cds::backoff::LockDefault> > lock_type ;
+        typedef policy_backoff<cds::backoff::yield> back_off ;
         typedef cds::opt::v::default_swap_policy    swap_policy ;
         typedef cds::opt::v::assignment_move_policy  move_policy ;
         typedef cds::intrusive::opt::v::empty_disposer  disposer ;
+        /* Siblings are locked together, give each pair its own cache line. */
+        enum { alignment = CACHE_LINE_SIZE / 2 };
     };
 
 private:
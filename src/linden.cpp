@@ -1,9 +1,120 @@
 #include "linden.h"
 
+#include <cstdlib>
+#include <vector>
+
+#include <cds/init.h>
+#include <cds/urcu/general_buffered.h>
+#include <cds/urcu/general_instant.h>
+
 extern "C" {
-#include "linden/gc/gc.h"
+#include "gc/alloc.h"
+#include "gc/gc.h"
 }
 
+/**
+ * Reclamation through one of libcds' user-space RCU flavours. Operations
+ * are read-side critical sections. Nodes retired during an operation are
+ * collected per thread and handed to RCU after the thread has left the
+ * critical section, since retiring may wait for a grace period. Threads
+ * attach to libcds on their first operation and detach when they exit.
+ */
+template <typename RCU>
+class urcu_smr
+{
+public:
+    static const pq_smr_t *
+    get()
+    {
+        static domain_t domain;
+        static const pq_smr_t smr = { enter, exit, alloc, retire, free_node };
+        return &smr;
+    }
+
+private:
+    struct domain_t {
+        domain_t() { cds::Initialize(); m_rcu = new RCU(); }
+        ~domain_t() { delete m_rcu; cds::Terminate(); }
+
+        RCU *m_rcu;
+    };
+
+    struct thread_t {
+        thread_t()
+            : m_attached(!cds::threading::Manager::isThreadAttached())
+        {
+            if (m_attached) {
+                cds::threading::Manager::attachThread();
+            }
+        }
+
+        ~thread_t()
+        {
+            flush();
+            if (m_attached) {
+                cds::threading::Manager::detachThread();
+            }
+        }
+
+        void
+        flush()
+        {
+            if (!m_retired.empty()) {
+                RCU::batch_retire(m_retired.begin(), m_retired.end());
+                m_retired.clear();
+            }
+        }
+
+        const bool m_attached;
+        std::vector<cds::urcu::retired_ptr> m_retired;
+    };
+
+    static thread_t &
+    thread()
+    {
+        static thread_local thread_t t;
+        return t;
+    }
+
+    static void
+    enter()
+    {
+        thread();
+        RCU::access_lock();
+    }
+
+    static void
+    exit()
+    {
+        RCU::access_unlock();
+        if (!RCU::is_locked()) {
+            thread().flush();
+        }
+    }
+
+    static void *
+    alloc(size_t size)
+    {
+        return (node_allocator != nullptr) ? node_allocator->alloc(size) : malloc(size);
+    }
+
+    static void
+    retire(void *p)
+    {
+        thread().m_retired.push_back(cds::urcu::retired_ptr(p, free_node));
+    }
+
+    static void
+    free_node(void *p)
+    {
+        if (node_allocator != nullptr) {
+            node_allocator->free(p);
+        } else {
+            ::free(p);
+        }
+    }
+};
+
 static inline void
 linden_insert(pq_t *pq,
               const uint32_t v)
@@ -29,9 +140,56 @@ Linden::insert(const uint32_t v)
     linden_insert(m_q, v);
 }
 
+void
+Linden::insert_sorted(const uint32_t *vs,
+                      const size_t n)
+{
+    ::insert_sorted(m_q, vs, vs, n);
+}
+
 bool
 Linden::delete_min(uint32_t &v)
 {
     v = deletemin(m_q);
     return true;
 }
+
+int
+Linden::max_offset() const
+{
+    return __atomic_load_n(&m_q->max_offset, __ATOMIC_RELAXED);
+}
+
+void
+Linden::set_max_offset(const int max_offset)
+{
+    __atomic_store_n(&m_q->max_offset, max_offset, __ATOMIC_RELAXED);
+}
+
+void
+Linden::set_adaptive(const bool adaptive)
+{
+    pq_set_adaptive(m_q, adaptive);
+}
+
+void
+Linden::set_finger(const bool finger)
+{
+    pq_set_finger(m_q, finger);
+}
+
+void
+Linden::set_reclamation(const reclamation_t reclamation)
+{
+    switch (reclamation) {
+    case RECLAIM_EPOCH:
+        pq_set_smr(m_q, nullptr);
+        break;
+    case RECLAIM_URCU_BUFFERED:
+        pq_set_smr(m_q, urcu_smr<cds::urcu::gc<cds::urcu::general_buffered<>>>::get());
+        break;
+    case RECLAIM_URCU_INSTANT:
+        pq_set_smr(m_q, urcu_smr<cds::urcu::gc<cds::urcu::general_instant<>>>::get());
+        break;
+    }
+}
@@ -8,12 +8,40 @@ extern "C" {
 class Linden
 {
 public:
+    /** Schemes reclaiming the nodes removed by delete_min(). */
+    enum reclamation_t {
+        RECLAIM_EPOCH,          /**< Fraser's epoch based collector. */
+        RECLAIM_URCU_BUFFERED,  /**< libcds' general purpose RCU, buffering retired nodes. */
+        RECLAIM_URCU_INSTANT,   /**< libcds' general purpose RCU, one grace period per operation. */
+    };
+
     Linden(const int max_offset);
     virtual ~Linden();
 
     void insert(const uint32_t v);
+
+    /** Inserts the n keys vs, which must be in ascending order, reusing
+     * the search for each key to find the next. */
+    void insert_sorted(const uint32_t *vs, const size_t n);
+
     bool delete_min(uint32_t &v);
 
+    /** The number of deleted nodes traversed before the head is moved
+     * and the deleted prefix reclaimed. */
+    int max_offset() const;
+    void set_max_offset(const int max_offset);
+
+    /** Adapts max_offset to the observed contention at runtime. */
+    void set_adaptive(const bool adaptive);
+
+    /** Starts each thread's inserts at its previous insertion if possible,
+     * which pays off when keys land close to each other. */
+    void set_finger(const bool finger);
+
+    /** Selects how nodes are reclaimed, before the first insert. Finger
+     * search is only available with RECLAIM_EPOCH. */
+    void set_reclamation(const reclamation_t reclamation);
+
 private:
     pq_t *m_q;
 };
@@ -0,0 +1,58 @@
+#include "michael.h"
+
+extern "C" {
+#include "gc/alloc.h"
+}
+
+namespace michael {
+
+typedef cds::memory::michael::Heap<
+    cds::memory::michael::opt::procheap_stat<cds::memory::michael::procheap_atomic_stat>,
+    cds::memory::michael::opt::os_allocated_stat<cds::memory::michael::os_allocated_atomic>
+> heap_t;
+
+/** Never destroyed: the queues are static objects themselves, and free
+ * their remaining nodes into it on exit. */
+static heap_t *heap;
+
+static void *
+alloc(size_t size)
+{
+    return heap->alloc(size);
+}
+
+static void *
+alloc_aligned(size_t size,
+              size_t alignment)
+{
+    return heap->alloc_aligned(size, alignment);
+}
+
+/** Also takes blocks from alloc_aligned(), as Heap::free_aligned() does. */
+static void
+free(void *p)
+{
+    heap->free(p);
+}
+
+static const alloc_t allocator = { alloc, alloc_aligned, free };
+
+void
+install()
+{
+    if (heap == nullptr) {
+        heap = new heap_t();
+    }
+    set_node_allocator(&allocator);
+}
+
+void
+get_stats(stat_t &stat)
+{
+    stat.clear();
+    if (heap != nullptr) {
+        heap->summaryStat(stat);
+    }
+}
+
+}
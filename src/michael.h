@@ -0,0 +1,25 @@
+#ifndef __MICHAEL_H
+#define __MICHAEL_H
+
+#include <cds/memory/michael/allocator.h>
+
+/**
+ * Maged Michael's lock-free allocator from libcds, as the node allocator
+ * of all queues (see gc/alloc.h). It carves blocks of a few dozen size
+ * classes out of superblocks, each owned by a per processor heap, and
+ * takes large blocks from the OS directly. Statistics are gathered on
+ * both.
+ */
+namespace michael {
+
+typedef cds::memory::michael::summary_stat stat_t;
+
+/** Installs the allocator, before the queues allocate their first node. */
+void install();
+
+/** Statistics summed over all processor heaps. */
+void get_stats(stat_t &stat);
+
+}
+
+#endif /* __MICHAEL_H */
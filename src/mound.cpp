@@ -0,0 +1,382 @@
+#include "mound.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/** Tag of words holding a descriptor instead of a state. */
+static constexpr uintptr_t DESC = 1;
+
+/** Random leaves probed before the mound grows by a level. */
+static constexpr int GROW_THRESHOLD = 8;
+
+static inline int
+level_of(const size_t i)
+{
+    return 63 - __builtin_clzll(i + 1);
+}
+
+/** The ancestor of node i at the given level; i is at a level >= level. */
+static inline size_t
+ancestor(const size_t i,
+         const int level)
+{
+    return ((i + 1) >> (level_of(i) - level)) - 1;
+}
+
+static inline uint64_t
+next_rand()
+{
+    static __thread uint64_t seed = 0;
+    if (seed == 0) {
+        seed = (uintptr_t)&seed | 1;
+    }
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+Mound::Mound() :
+    m_depth(1)
+{
+    for (int i = 0; i < MAX_LEVELS; i++) {
+        m_levels[i].store(nullptr);
+    }
+    m_levels[0].store(static_cast<word_t *>(calloc(1, sizeof(word_t))));
+}
+
+Mound::~Mound()
+{
+    /* States and list nodes belong to the GC pools. */
+    for (int i = 0; i < MAX_LEVELS; i++) {
+        free(m_levels[i].load());
+    }
+}
+
+Mound::word_t *
+Mound::node(const size_t i) const
+{
+    const int l = level_of(i);
+    return &m_levels[l].load()[i + 1 - (1ULL << l)];
+}
+
+/** The minimum of state s, or UINT32_MAX if its node is empty. */
+uint32_t
+Mound::value(const state_t *s)
+{
+    return (s == nullptr || s->list == nullptr) ? UINT32_MAX : s->list->v;
+}
+
+Mound::state_t *
+Mound::read(const size_t i)
+{
+    while (true) {
+        const uintptr_t w = node(i)->load();
+        if ((w & DESC) == 0) {
+            return reinterpret_cast<state_t *>(w);
+        }
+        help(reinterpret_cast<dcas_t *>(w & ~DESC));
+    }
+}
+
+Mound::state_t *
+Mound::new_state(lnode_t *list,
+                 const bool dirty)
+{
+    state_t *s = m_states.alloc();
+    s->list = list;
+    s->dirty = dirty;
+    return s;
+}
+
+/**
+ * Replaces the state of node i. On success, the old state is retired.
+ * On failure, the unpublished new state is recycled immediately.
+ */
+bool
+Mound::cas(const size_t i,
+           state_t *expected,
+           state_t *desired)
+{
+    uintptr_t e = reinterpret_cast<uintptr_t>(expected);
+    if (node(i)->compare_exchange_strong(e, reinterpret_cast<uintptr_t>(desired))) {
+        if (expected != nullptr) {
+            m_states.retire(expected);
+        }
+        return true;
+    }
+
+    m_states.release(desired);
+    return false;
+}
+
+/**
+ * Atomically replaces the states of nodes i and j. An entry whose
+ * expected and desired states are equal is only compared, which turns
+ * this into a double-compare single-swap. States are retired as in cas().
+ */
+bool
+Mound::dcas(const size_t i,
+            state_t *i_expected,
+            state_t *i_desired,
+            const size_t j,
+            state_t *j_expected,
+            state_t *j_desired)
+{
+    dcas_t *d = m_dcas.alloc();
+    d->status.store(DCAS_UNDECIDED);
+
+    /* Words are acquired in address order, so helpers never cycle. */
+    dcas_entry_t ei = { node(i), reinterpret_cast<uintptr_t>(i_expected),
+                        reinterpret_cast<uintptr_t>(i_desired) };
+    dcas_entry_t ej = { node(j), reinterpret_cast<uintptr_t>(j_expected),
+                        reinterpret_cast<uintptr_t>(j_desired) };
+    d->e[0] = (ei.addr < ej.addr) ? ei : ej;
+    d->e[1] = (ei.addr < ej.addr) ? ej : ei;
+
+    const bool ok = help(d);
+
+    for (int k = 0; k < 2; k++) {
+        const dcas_entry_t &e = d->e[k];
+        if (e.expected == e.desired) {
+            continue;
+        }
+
+        if (ok && e.expected != 0) {
+            m_states.retire(reinterpret_cast<state_t *>(e.expected));
+        } else if (!ok) {
+            m_states.release(reinterpret_cast<state_t *>(e.desired));
+        }
+    }
+
+    m_dcas.retire(d);
+
+    return ok;
+}
+
+bool
+Mound::help(dcas_t *d)
+{
+    const uintptr_t marked = reinterpret_cast<uintptr_t>(d) | DESC;
+
+    /* Install the descriptor in both words, or decide on failure. */
+    for (int k = 0; k < 2 && d->status.load() == DCAS_UNDECIDED; k++) {
+        const dcas_entry_t &e = d->e[k];
+        while (true) {
+            uintptr_t w = e.addr->load();
+            if (w == marked) {
+                break;
+            }
+
+            if (w & DESC) {
+                help(reinterpret_cast<dcas_t *>(w & ~DESC));
+                continue;
+            }
+
+            if (w != e.expected) {
+                int u = DCAS_UNDECIDED;
+                d->status.compare_exchange_strong(u, DCAS_FAILED);
+                break;
+            }
+
+            if (e.addr->compare_exchange_strong(w, marked)) {
+                break;
+            }
+        }
+    }
+
+    int u = DCAS_UNDECIDED;
+    d->status.compare_exchange_strong(u, DCAS_SUCCEEDED);
+
+    /* Replace the descriptor by the outcome. States are never reused
+     * while we are in a critical section, so a late helper which installs
+     * the descriptor after the decision removes it again right here. */
+    const bool ok = (d->status.load() == DCAS_SUCCEEDED);
+    for (int k = 0; k < 2; k++) {
+        const dcas_entry_t &e = d->e[k];
+        uintptr_t m = marked;
+        e.addr->compare_exchange_strong(m, ok ? e.desired : e.expected);
+    }
+
+    return ok;
+}
+
+void
+Mound::grow(const int depth)
+{
+    if (depth == MAX_LEVELS) {
+        fprintf(stderr, "Mound: exceeded %d levels\n", MAX_LEVELS);
+        exit(EXIT_FAILURE);
+    }
+
+    if (m_levels[depth].load() == nullptr) {
+        word_t *level = static_cast<word_t *>(calloc(1ULL << depth, sizeof(word_t)));
+        word_t *expected = nullptr;
+        if (!m_levels[depth].compare_exchange_strong(expected, level)) {
+            free(level);
+        }
+    }
+
+    int d = depth;
+    m_depth.compare_exchange_strong(d, depth + 1);
+}
+
+size_t
+Mound::find_insert_point(const uint32_t v)
+{
+    while (true) {
+        const int d = m_depth.load();
+        const size_t first_leaf = (1ULL << (d - 1)) - 1;
+
+        for (int a = 0; a < GROW_THRESHOLD; a++) {
+            const size_t leaf = first_leaf + next_rand() % (1ULL << (d - 1));
+            if (value(read(leaf)) < v) {
+                continue;
+            }
+
+            /* Heads along the path are sorted, find the shallowest one
+             * which is not smaller than v. */
+            int lo = 0, hi = d - 1;
+            while (lo < hi) {
+                const int mid = (lo + hi) / 2;
+                if (value(read(ancestor(leaf, mid))) >= v) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+
+            return ancestor(leaf, lo);
+        }
+
+        grow(d);
+    }
+}
+
+void
+Mound::moundify(size_t n)
+{
+    while (true) {
+        state_t *N = read(n);
+        if (N == nullptr || !N->dirty) {
+            return;
+        }
+
+        const size_t l = 2 * n + 1;
+        const size_t r = 2 * n + 2;
+
+        if (level_of(l) >= m_depth.load()) {
+            if (cas(n, N, new_state(N->list, false))) {
+                return;
+            }
+            continue;
+        }
+
+        state_t *L = read(l);
+        if (L != nullptr && L->dirty) {
+            moundify(l);
+            continue;
+        }
+
+        state_t *R = read(r);
+        if (R != nullptr && R->dirty) {
+            moundify(r);
+            continue;
+        }
+
+        const uint32_t nv = value(N);
+        const uint32_t lv = value(L);
+        const uint32_t rv = value(R);
+
+        if (lv <= rv && lv < nv) {
+            /* Swap lists with the left child, which becomes dirty. */
+            if (dcas(n, N, new_state(L == nullptr ? nullptr : L->list, false),
+                     l, L, new_state(N->list, true))) {
+                n = l;
+            }
+        } else if (rv < lv && rv < nv) {
+            if (dcas(n, N, new_state(R == nullptr ? nullptr : R->list, false),
+                     r, R, new_state(N->list, true))) {
+                n = r;
+            }
+        } else if (cas(n, N, new_state(N->list, false))) {
+            return;
+        }
+    }
+}
+
+void
+Mound::insert(const uint32_t v)
+{
+    /* Reserved as the value of empty nodes. */
+    assert(v != UINT32_MAX);
+
+    epoch::guard g;
+
+    lnode_t *ln = m_lnodes.alloc();
+    ln->v = v;
+
+    while (true) {
+        const size_t c = find_insert_point(v);
+
+        state_t *C = read(c);
+        if (value(C) < v) {
+            continue;
+        }
+
+        ln->next = (C == nullptr) ? nullptr : C->list;
+        state_t *C2 = new_state(ln, C != nullptr && C->dirty);
+
+        if (c == 0) {
+            if (cas(c, C, C2)) {
+                break;
+            }
+            continue;
+        }
+
+        const size_t p = (c - 1) / 2;
+        state_t *P = read(p);
+        if (value(P) > v) {
+            m_states.release(C2);
+            continue;
+        }
+
+        /* Only install C2 if the parent has not changed meanwhile. */
+        if (dcas(c, C, C2, p, P, P)) {
+            break;
+        }
+    }
+}
+
+bool
+Mound::delete_min(uint32_t &v)
+{
+    bool found = false;
+
+    epoch::guard g;
+
+    while (true) {
+        state_t *R = read(0);
+        if (R != nullptr && R->dirty) {
+            moundify(0);
+            continue;
+        }
+
+        if (R == nullptr || R->list == nullptr) {
+            break;
+        }
+
+        lnode_t *head = R->list;
+        if (cas(0, R, new_state(head->next, true))) {
+            v = head->v;
+            m_lnodes.retire(head);
+            found = true;
+            moundify(0);
+            break;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,101 @@
+#ifndef __MOUND_H
+#define __MOUND_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "gc/epoch.h"
+
+/**
+ * The lock-free Mound of Liu and Spear: a binary tree of sorted lists in
+ * which every node's list head is no larger than those of its children.
+ *
+ * insert() picks a random leaf whose head is not smaller than the key, and
+ * binary searches the path from the root to it for the insertion point,
+ * which takes O(log log n) node reads. delete_min() pops the root's list
+ * and restores the mound property by swapping lists downwards (moundify).
+ *
+ * Tree nodes are single words pointing at immutable states. Every update
+ * installs a freshly allocated state, which together with epoch based
+ * reclamation rules out ABA. The double-word CAS required by moundify (and
+ * the double-compare single-swap of insert) is emulated with CAS by
+ * installing a descriptor in both words, which other threads help to
+ * complete. List nodes, states and descriptors come from the epoch GC.
+ */
+class Mound
+{
+public:
+    Mound();
+    virtual ~Mound();
+
+    /** Inserts v, which must not be UINT32_MAX. */
+    void insert(const uint32_t v);
+    bool delete_min(uint32_t &v);
+
+private:
+    static constexpr int MAX_LEVELS = 32;
+
+    /** Immutable sorted list node. */
+    struct lnode_t {
+        lnode_t *next;
+        uint32_t v;
+    };
+
+    /** Immutable node state. A null state is an empty, clean node. */
+    struct state_t {
+        lnode_t *list;
+        bool dirty;
+    };
+
+    typedef std::atomic<uintptr_t> word_t;
+
+    struct dcas_entry_t {
+        word_t *addr;
+        uintptr_t expected;
+        uintptr_t desired;
+    };
+
+    enum dcas_status_t {
+        DCAS_UNDECIDED,
+        DCAS_SUCCEEDED,
+        DCAS_FAILED,
+    };
+
+    struct dcas_t {
+        std::atomic<int> status;
+        dcas_entry_t e[2];
+    };
+
+    word_t *node(const size_t i) const;
+    state_t *read(const size_t i);
+    static uint32_t value(const state_t *s);
+
+    state_t *new_state(lnode_t *list,
+                       const bool dirty);
+
+    bool cas(const size_t i,
+             state_t *expected,
+             state_t *desired);
+    bool dcas(const size_t i,
+              state_t *i_expected,
+              state_t *i_desired,
+              const size_t j,
+              state_t *j_expected,
+              state_t *j_desired);
+    bool help(dcas_t *d);
+
+    size_t find_insert_point(const uint32_t v);
+    void grow(const int depth);
+    void moundify(size_t n);
+
+private:
+    std::atomic<word_t *> m_levels[MAX_LEVELS];
+    std::atomic<int> m_depth;
+
+    epoch::pool<lnode_t> m_lnodes;
+    epoch::pool<state_t> m_states;
+    epoch::pool<dcas_t> m_dcas;
+};
+
+#endif /* __MOUND_H */
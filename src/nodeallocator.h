@@ -0,0 +1,66 @@
+#ifndef __NODEALLOCATOR_H
+#define __NODEALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+extern "C" {
+#include "gc/alloc.h"
+}
+
+/**
+ * Standard allocator drawing from the node allocator installed with
+ * set_node_allocator(), and from std::allocator while none is.
+ */
+template <typename T>
+class NodeAllocator
+{
+public:
+    typedef T value_type;
+
+    NodeAllocator() { }
+    template <typename U>
+    NodeAllocator(const NodeAllocator<U> &) { }
+
+    T *
+    allocate(const size_t n)
+    {
+        if (node_allocator == nullptr) {
+            return std::allocator<T>().allocate(n);
+        }
+
+        T *p = static_cast<T *>(node_allocator->alloc(n * sizeof(T)));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void
+    deallocate(T *p,
+               const size_t n)
+    {
+        if (node_allocator == nullptr) {
+            std::allocator<T>().deallocate(p, n);
+        } else {
+            node_allocator->free(p);
+        }
+    }
+};
+
+template <typename T, typename U>
+bool
+operator==(const NodeAllocator<T> &, const NodeAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const NodeAllocator<T> &, const NodeAllocator<U> &)
+{
+    return false;
+}
+
+#endif /* __NODEALLOCATOR_H */
@@ -3,38 +3,168 @@
 #include <limits>
 #include <hwloc.h>
 #include <random>
+#include <vector>
 
+#include "bucketqueue.h"
+#include "buffered.h"
+#include "cachemisses.h"
+#include "delegation.h"
+#include "elimination.h"
 #include "globallock.h"
 #include "heap.h"
 #include "linden.h"
+#include "michael.h"
+#include "mound.h"
 #include "noble.h"
 #include "spraylist.h"
 
+extern "C" {
+#include "gc/backoff.h"
+#include "gc/gc.h"
+}
+
 #undef max /* Clash between macro and limits. */
 #undef min
 
 #define DEFAULT_SECS     (10)
 #define DEFAULT_NTHREADS (1)
+#define DEFAULT_NSERVERS (1)
 #define DEFAULT_OFFSET   (32)
 #define DEFAULT_SIZE     (1 << 15)
 #define DEFAULT_VERBOSE  (false)
+#define DEFAULT_ELIMINATE (false)
+#define DEFAULT_BUFFER   (0)
+#define DEFAULT_ADAPTIVE (false)
+#define DEFAULT_MISSES   (false)
+#define DEFAULT_FINGER   (false)
+#define DEFAULT_NUMA     (false)
+#define DEFAULT_TRIM_MB  (64)
+#define DEFAULT_BACKLOG  (0)
+#define DEFAULT_PER_CORE (1)
+
+/** Interval between reports of Linden's adaptive offset. */
+#define OFFSET_SAMPLE_MS (100)
+#define DEFAULT_KEYS     (KEYS_UNIFORM)
+
+/** Width of a monotone key's window above the last deleted key. */
+#define MONOTONE_RANGE   (1 << 16)
+/** Buckets span 2^DEFAULT_BUCKET_SHIFT keys each. */
+#define DEFAULT_BUCKET_SHIFT (15)
+/** Keys go up to INT_MAX, so narrower buckets would take over 32 MB of
+ * cache line sized buckets. */
+#define MIN_BUCKET_SHIFT (12)
+
+enum key_pattern_t {
+    KEYS_UNIFORM,  /**< Keys drawn uniformly from [1, INT_MAX]. */
+    KEYS_MONOTONE, /**< Keys drawn from (last deleted, + MONOTONE_RANGE]. */
+};
 
 static std::atomic<bool> loop;
 static std::atomic<int> wait_barrier;
 
 static GlobalLock pq_globallock;
-static Heap pq_heap(DEFAULT_SIZE << 3);
+static Heap pq_heap(DEFAULT_SIZE);
 static Noble pq_noble;
 static Linden pq_linden(DEFAULT_OFFSET);
 static SprayList pq_spraylist;
+/** Only constructed if selected, its buckets take megabytes. */
+static BucketQueue *pq_bucket;
+static Delegation pq_delegation;
+static Mound pq_mound;
+static Elimination<Linden> pq_linden_elim(pq_linden);
+static Elimination<SprayList> pq_spraylist_elim(pq_spraylist);
 
 typedef void (*fn_insert)(const uint32_t);
+typedef void (*fn_insert_sorted)(const uint32_t *, const size_t);
 typedef bool (*fn_delete_min)(uint32_t &);
+typedef void (*fn_print_stats)(FILE *);
 
 static fn_insert ins;
 static fn_delete_min del;
+static fn_print_stats print_stats;
+
+/** The queue selected on the command line, as seen by wrappers. */
+struct selected_pq {
+    fn_insert ins;
+    fn_insert_sorted ins_sorted; /**< Optional batched insert. */
+    fn_delete_min del;
+
+    void insert(const uint32_t v) { ins(v); }
+    void insert_sorted(const uint32_t *vs, const size_t n)
+    {
+        if (ins_sorted != nullptr) {
+            ins_sorted(vs, n);
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            ins(vs[i]);
+        }
+    }
+    bool delete_min(uint32_t &v) { return del(v); }
+};
+
+static selected_pq pq_selected;
+static Buffered<selected_pq> *pq_buffered;
+
+static key_pattern_t key_pattern = DEFAULT_KEYS;
+
+static bool count_misses = DEFAULT_MISSES;
+static uint64_t init_misses;
+static uint64_t init_cycles;
+/** Misses and calls while running, per operation type. */
+static std::atomic<uint64_t> run_ins_misses;
+static std::atomic<uint64_t> run_del_misses;
+static std::atomic<uint64_t> run_inserts;
+static std::atomic<uint64_t> run_deletes;
 
 static hwloc_topology_t topology;
+/** Benchmark threads pinned to each core. */
+static int threads_per_core = DEFAULT_PER_CORE;
+
+struct server_args_t {
+    pthread_t thread;
+    int id;
+    int nservers;
+    int nthreads;
+};
+
+/**
+ * Returns the next key to insert. base is the last key deleted by the
+ * calling thread, and is only relevant for monotone keys.
+ */
+static uint32_t
+next_key(std::mt19937 &gen,
+         const uint32_t base)
+{
+    /* Linden reserves key 0 for its head sentinel. */
+    std::uniform_int_distribution<> dis(1, std::numeric_limits<int>::max());
+    const uint32_t k = dis(gen);
+
+    switch (key_pattern) {
+    case KEYS_MONOTONE: return base + 1 + k % MONOTONE_RANGE;
+    default: return k;
+    }
+}
+
+/** Unit of timestamp(). */
+#if defined(__x86_64__) || defined(__i386__)
+#define TIMESTAMP_UNIT "Cycles"
+#else
+#define TIMESTAMP_UNIT "Ns"
+#endif
+
+/** The time stamp counter on x86, and monotonic nanoseconds elsewhere. */
+static inline uint64_t
+timestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec t;
+    gettime(&t);
+    return t.tv_sec * 1000000000ULL + t.tv_nsec;
+#endif
+}
 
 template <typename T>
 static void
@@ -43,11 +173,173 @@ pq_init(T &pq,
 {
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis;
 
-    for (int i = 0; i < size; i++) {
-        pq.insert(dis(gen));
+    /* Drawn beforehand, so that only the inserts are measured. */
+    std::vector<uint32_t> keys(size);
+    for (size_t i = 0; i < size; i++) {
+        keys[i] = next_key(gen, 0);
+    }
+
+    CacheMisses *misses = count_misses ? new CacheMisses() : nullptr;
+    const uint64_t start = (misses == nullptr) ? 0 : misses->read();
+    const uint64_t tsc = timestamp();
+
+    for (size_t i = 0; i < size; i++) {
+        pq.insert(keys[i]);
+    }
+
+    init_cycles = timestamp() - tsc;
+
+    if (misses != nullptr) {
+        init_misses = misses->read() - start;
+        delete misses;
+    }
+}
+
+template <typename T>
+static void
+print_elimination_stats(FILE *out,
+                        const Elimination<T> &pq)
+{
+    fprintf(out, "Eliminated:\t%lu\n", pq.eliminated());
+    fprintf(out, "Elim. timeouts:\t%lu\n", pq.timeouts());
+}
+
+/** Deletes by the number of failed sprays before they succeeded. */
+static void
+print_spray_stats(FILE *out)
+{
+    uint64_t counts[SL_SPRAY_RETRIES + 1];
+    pq_spraylist.retries(counts);
+
+    fprintf(out, "Spray retries:\t");
+    for (int i = 0; i < SL_SPRAY_RETRIES; i++) {
+        fprintf(out, "%d: %lu, ", i, counts[i]);
+    }
+    fprintf(out, "naive: %lu\n", counts[SL_SPRAY_RETRIES]);
+}
+
+/** Resident set size of the process in bytes, 0 if unknown. */
+static size_t
+rss_bytes()
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+
+    unsigned long size, resident;
+    const int n = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+
+    return (n == 2) ? resident * sysconf(_SC_PAGESIZE) : 0;
+}
+
+/** Epoch GC statistics, summed over all threads. */
+static void
+print_gc_stats(FILE *out)
+{
+    gc_stats_t stats;
+    gc_get_stats(nullptr, &stats);
+
+    fprintf(out, "GC epochs:\t%lu\n", stats.epochs);
+    fprintf(out, "GC reclaims:\t%lu (%lu stalled, %lu busy)\n",
+            stats.reclaims, stats.reclaim_stalls, stats.reclaim_busy);
+    fprintf(out, "GC throttles:\t%lu (peak backlog %lu blocks)\n",
+            stats.throttles, stats.peak_backlog);
+    fprintf(out, "GC trimmed:\t%zu bytes\n", stats.trimmed);
+
+    for (int i = 0; i < stats.nr_sizes; i++) {
+        if (stats.sizes[i].allocated == 0) {
+            continue;
+        }
+        fprintf(out, "GC %d bytes:\t%lu allocated, %lu freed, %lu recycled, %lu backlog\n",
+                stats.sizes[i].size, stats.sizes[i].allocated, stats.sizes[i].freed,
+                stats.sizes[i].recycled, stats.sizes[i].backlog);
+    }
+
+    for (int i = 0; i < stats.nr_hooks; i++) {
+        fprintf(out, "GC hook %d:\t%lu queued, %lu run, %lu backlog\n",
+                i, stats.hooks[i].queued, stats.hooks[i].run, stats.hooks[i].backlog);
+    }
+}
+
+/** Statistics of Michael's allocator, summed over all processor heaps. */
+static void
+print_michael_stats(FILE *out)
+{
+    michael::stat_t stat;
+    michael::get_stats(stat);
+
+    fprintf(out, "Michael allocs:\t%zu (%zu active, %zu partial, %zu new superblock)\n",
+            stat.nAllocFromActive + stat.nAllocFromPartial + stat.nAllocFromNew,
+            stat.nAllocFromActive, stat.nAllocFromPartial, stat.nAllocFromNew);
+    fprintf(out, "Michael frees:\t%zu\n", stat.nFreeCount);
+    fprintf(out, "Michael bytes:\t%lu allocated, %lu freed\n",
+            (unsigned long)stat.nBytesAllocated, (unsigned long)stat.nBytesDeallocated);
+    fprintf(out, "Michael pages:\t%zu allocated, %zu freed, %zu descriptors, %zu full\n",
+            stat.nPageAllocCount, stat.nPageDeallocCount, stat.nDescAllocCount, stat.nDescFull);
+    fprintf(out, "Michael CAS:\t%zu/%zu active, %zu/%zu partial failures (desc/anchor)\n",
+            stat.nActiveDescCASFailureCount, stat.nActiveAnchorCASFailureCount,
+            stat.nPartialDescCASFailureCount, stat.nPartialAnchorCASFailureCount);
+    fprintf(out, "Michael OS:\t%zu allocs, %zu frees, %lu bytes allocated, %ld freed\n",
+            stat.nSysAllocCount, stat.nSysFreeCount,
+            (unsigned long)stat.nSysBytesAllocated, (long)stat.nSysBytesDeallocated);
+}
+
+/**
+ * Parses comma separated spray parameters, e.g. "height=4,max=2,adaptive",
+ * into spray. Returns false on malformed input.
+ */
+static bool
+parse_spray(const char *str,
+            sl_spray_t &spray)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", str);
+
+    char *save;
+    for (char *tok = strtok_r(buf, ",", &save); tok != nullptr;
+         tok = strtok_r(nullptr, ",", &save)) {
+        if (strcmp(tok, "adaptive") == 0) {
+            spray.adaptive = 1;
+            continue;
+        }
+
+        char key[16];
+        int val;
+        if (sscanf(tok, "%15[a-z]=%d", key, &val) != 2) {
+            return false;
+        }
+
+        if (strcmp(key, "height") == 0 && val >= 0) {
+            spray.height = val;
+        } else if (strcmp(key, "max") == 0 && val >= 0) {
+            spray.scanmax = val;
+        } else if (strcmp(key, "inc") == 0) {
+            spray.scaninc = val;
+        } else if (strcmp(key, "skip") == 0 && val > 0) {
+            spray.scanskip = val;
+        } else if (strcmp(key, "clean") == 0 && val >= 0) {
+            spray.clean = val;
+        } else {
+            return false;
+        }
     }
+
+    /* A negative inc shortens the jumps at each step down, which must not
+     * make them negative. The defaults depend on the number of threads,
+     * so both the height and max are needed to check. */
+    if (spray.scaninc < 0) {
+        const int skip = spray.scanskip > 0 ? spray.scanskip : 1;
+        const int steps = (spray.height + skip - 1) / skip;
+        if (spray.height == 0 || spray.scanmax == 0 ||
+            spray.scanmax + (long)steps * spray.scaninc < 0) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 static void
@@ -59,16 +351,67 @@ usage(FILE *out,
         "Options:\n", argv0);
 
     fprintf(out, "\t-h\t\tDisplay usage.\n");
-    fprintf(out, "\t-q QUEUE\tRun benchmarks on queue of type TYPE (globallock|heap|linden|noble|spraylist).\n");
+    fprintf(out, "\t-q QUEUE\tRun benchmarks on queue of type TYPE (bucket|delegation|globallock|heap|linden|mound|noble|spraylist).\n");
     fprintf(out, "\t-t SECS\t\tRun for SECS seconds. "
         "Default: %i\n",
         DEFAULT_SECS);
     fprintf(out, "\t-n NUM\t\tUse NUM threads. "
         "Default: %i\n",
         DEFAULT_NTHREADS);
+    fprintf(out, "\t-a\t\tAdapt linden's offset at runtime, starting at OFFSET. "
+        "Reports the offset over time in verbose mode. Default: %i\n",
+        DEFAULT_ADAPTIVE);
+    fprintf(out, "\t-b SIZE\t\tBuffer up to SIZE inserts per thread before the queue (max %zu). "
+        "Default: %i\n",
+        Buffered<selected_pq>::MAX_CAPACITY, DEFAULT_BUFFER);
+    fprintf(out, "\t-d NUM\t\tUse NUM server threads for the delegation queue. "
+        "Default: %i\n",
+        DEFAULT_NSERVERS);
+    fprintf(out, "\t-f\t\tUse finger search for linden's inserts. "
+        "Default: %i\n",
+        DEFAULT_FINGER);
+    fprintf(out, "\t-o OFFSET\tSet linden's restructuring offset to OFFSET. "
+        "Default: %i\n",
+        DEFAULT_OFFSET);
+    fprintf(out, "\t-p\t\tGive each NUMA node its own huge page backed GC pools. "
+        "Default: %i\n",
+        DEFAULT_NUMA);
     fprintf(out, "\t-s SIZE\t\tInitialize queue with SIZE elements. "
         "Default: %i\n",
         DEFAULT_SIZE);
+    fprintf(out, "\t-e\t\tPut an elimination front-end before linden and spraylist. "
+        "Default: %i\n",
+        DEFAULT_ELIMINATE);
+    fprintf(out, "\t-l BLOCKS\tThrottle threads with more than BLOCKS unreclaimed GC blocks "
+        "while the epoch is stalled, e.g. with more threads than cores (0 disables). "
+        "Default: %i\n",
+        DEFAULT_BACKLOG);
+    fprintf(out, "\t-j NUM\t\tPin NUM threads to each core. More than 1 oversubscribes the cores, "
+        "so that threads are preempted within critical regions, see -l. Default: %i\n",
+        DEFAULT_PER_CORE);
+    fprintf(out, "\t-m\t\tCount L1 data cache misses per insert while prefilling, "
+        "and per insert and per delete_min while running, which slows the run down. "
+        "Reported in verbose mode. Default: %i\n",
+        DEFAULT_MISSES);
+    fprintf(out, "\t-w MB\t\tReturn GC memory to the OS once more than MB are free (0 disables). "
+        "Default: %i\n",
+        DEFAULT_TRIM_MB);
+    fprintf(out, "\t-k KEYS\t\tGenerate keys following pattern KEYS (uniform|monotone). "
+        "Default: uniform\n");
+    fprintf(out, "\t-u SHIFT\tGive the bucket queue's buckets 2^SHIFT keys each (%i-31), "
+        "which bounds how far its deletes are from the minimum. Default: %i\n",
+        MIN_BUCKET_SHIFT, DEFAULT_BUCKET_SHIFT);
+    fprintf(out, "\t-c BACKOFF\tBack off on contention in linden, spraylist and heap following BACKOFF "
+        "(none|exponential|adaptive). Default: none\n");
+    fprintf(out, "\t-x ALLOC\tAllocate the nodes of all queues following ALLOC (default|michael), "
+        "where default is each queue's own allocator. Default: default\n");
+    fprintf(out, "\t-r RECLAIM\tReclaim linden's nodes following RECLAIM "
+        "(epoch|urcu-buffered|urcu-instant). Default: epoch\n");
+    fprintf(out, "\t-y SPRAY\tSet spraylist's spray parameters as a comma separated list of "
+        "height=LEVEL, max=JUMPS, inc=JUMPS (if negative, with height and max), skip=LEVELS, "
+        "clean=N (1 in N deletes is exact), "
+        "and adaptive (adapt the jumps to collisions and live threads). "
+        "Default: derived from the number of threads\n");
     fprintf(out, "\t-v\tEnable verbose output. Default: %i\n",
         DEFAULT_VERBOSE);
 }
@@ -91,6 +434,21 @@ pin_to_core(const int id)
     hwloc_bitmap_free(cpuset);
 }
 
+/**
+ * Delegation server threads are pinned to the cores following those of
+ * the benchmark threads.
+ */
+static void *
+serve(void *args)
+{
+    server_args_t *as = (server_args_t *)args;
+
+    pin_to_core((as->nthreads + threads_per_core - 1) / threads_per_core + as->id);
+    pq_delegation.serve(as->id, as->nservers);
+
+    return NULL;
+}
+
 static void *
 run(void *args)
 {
@@ -98,13 +456,19 @@ run(void *args)
 
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_int_distribution<> rand_int;
     std::uniform_int_distribution<> rand_bool(0, 1);
 
     /* Special handling for SprayList. */
     pq_spraylist.init_thread(as->nthreads);
 
-    pin_to_core(as->id);
+    pin_to_core(as->id / threads_per_core);
+
+    CacheMisses *misses = count_misses ? new CacheMisses() : nullptr;
+
+    /* Set up the GC state before the clock starts. With several threads
+     * per core, they would otherwise do so within the first timed
+     * operations, while sharing the core. */
+    critical_online();
 
     // call in to main thread
     std::atomic_fetch_add(&wait_barrier, 1);
@@ -115,18 +479,51 @@ run(void *args)
     }
 
     uint32_t cnt = 0;
+    uint32_t last = 0;
+    uint64_t inserts = 0, ins_misses = 0;
+    uint64_t deletes = 0, del_misses = 0;
     /* start benchmark execution */
     do {
         uint32_t v;
         if (rand_bool(gen) == 0) {
-            ins(rand_int(gen));
+            const uint32_t k = next_key(gen, last);
+            const uint64_t m = (misses == nullptr) ? 0 : misses->read();
+            ins(k);
+            if (misses != nullptr) {
+                ins_misses += misses->read() - m;
+            }
+            inserts++;
         } else {
-            del(v);
+            const uint64_t m = (misses == nullptr) ? 0 : misses->read();
+            const bool found = del(v);
+            if (misses != nullptr) {
+                del_misses += misses->read() - m;
+            }
+            deletes++;
+            if (found) {
+                last = v;
+            }
         }
         cnt++;
     } while (loop.load(std::memory_order_relaxed));
     /* end of measured execution */
 
+    if (misses != nullptr) {
+        run_ins_misses.fetch_add(ins_misses);
+        run_del_misses.fetch_add(del_misses);
+        run_inserts.fetch_add(inserts);
+        run_deletes.fetch_add(deletes);
+        delete misses;
+    }
+
+    if (pq_buffered != nullptr) {
+        pq_buffered->flush();
+    }
+
+    /* Hand our state and its garbage over right away, rather than at
+     * thread exit. */
+    critical_offline();
+
     as->measure = cnt;
 
     return NULL;
@@ -137,31 +534,177 @@ main(int argc __attribute__ ((unused)),
      char **argv __attribute__ ((unused)))
 {
     int nthreads  = DEFAULT_NTHREADS;
+    int nservers  = DEFAULT_NSERVERS;
     int secs      = DEFAULT_SECS;
     int init_size = DEFAULT_SIZE;
     bool verbose  = DEFAULT_VERBOSE;
+    bool eliminate = DEFAULT_ELIMINATE;
+    int buffer    = DEFAULT_BUFFER;
+    int offset    = DEFAULT_OFFSET;
+    bool adaptive = DEFAULT_ADAPTIVE;
+    bool finger   = DEFAULT_FINGER;
+    bool numa     = DEFAULT_NUMA;
+    int trim_mb   = DEFAULT_TRIM_MB;
+    int backlog   = DEFAULT_BACKLOG;
+    int bucket_shift = DEFAULT_BUCKET_SHIFT;
 
     const char *type_str = nullptr;
-
-    /* A hack to avoid segfault on destructor in empty linden queue. */
-    pq_linden.insert(42);
+    const char *keys_str = nullptr;
+    const char *backoff_str = nullptr;
+    const char *reclaim_str = nullptr;
+    const char *alloc_str = nullptr;
+    const char *spray_str = nullptr;
 
     int opt;
-    while ((opt = getopt(argc, argv, "hn:o:q:s:t:v")) >= 0) {
+    while ((opt = getopt(argc, argv, "ab:c:d:efhj:k:l:mn:o:pq:r:s:t:u:vw:x:y:")) >= 0) {
         switch (opt) {
+        case 'a': adaptive  = true; break;
+        case 'b': buffer    = atoi(optarg); break;
+        case 'c': backoff_str = optarg; break;
+        case 'd': nservers  = atoi(optarg); break;
+        case 'e': eliminate = true; break;
+        case 'f': finger    = true; break;
         case 'h': usage(stdout, argv[0]); exit(EXIT_SUCCESS); break;
+        case 'j': threads_per_core = atoi(optarg); break;
+        case 'k': keys_str  = optarg; break;
+        case 'l': backlog   = atoi(optarg); break;
+        case 'm': count_misses = true; break;
         case 'n': nthreads  = atoi(optarg); break;
+        case 'o': offset    = atoi(optarg); break;
+        case 'p': numa      = true; break;
         case 'q': type_str  = optarg; break;
+        case 'r': reclaim_str = optarg; break;
         case 's': init_size = atoi(optarg); break;
         case 't': secs      = atoi(optarg); break;
+        case 'u': bucket_shift = atoi(optarg); break;
         case 'v': verbose   = true; break;
+        case 'w': trim_mb   = atoi(optarg); break;
+        case 'x': alloc_str = optarg; break;
+        case 'y': spray_str = optarg; break;
         default: assert(0);
         }
     }
 
+    bool use_michael = false;
+    if (alloc_str == nullptr || strcmp(alloc_str, "default") == 0) {
+        use_michael = false;
+    } else if (strcmp(alloc_str, "michael") == 0) {
+        use_michael = true;
+    } else {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Before any queue allocates a node. */
+    if (use_michael) {
+        michael::install();
+    }
+
+    Linden::reclamation_t reclamation;
+    if (reclaim_str == nullptr || strcmp(reclaim_str, "epoch") == 0) {
+        reclamation = Linden::RECLAIM_EPOCH;
+    } else if (strcmp(reclaim_str, "urcu-buffered") == 0) {
+        reclamation = Linden::RECLAIM_URCU_BUFFERED;
+    } else if (strcmp(reclaim_str, "urcu-instant") == 0) {
+        reclamation = Linden::RECLAIM_URCU_INSTANT;
+    } else {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (finger && reclamation != Linden::RECLAIM_EPOCH) {
+        fprintf(stderr, "Finger search requires epoch reclamation\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pq_linden.set_max_offset(offset);
+    pq_linden.set_adaptive(adaptive);
+    pq_linden.set_finger(finger);
+    pq_linden.set_reclamation(reclamation);
+
+    /* A hack to avoid segfault on destructor in empty linden queue. */
+    pq_linden.insert(42);
+
+    /* The static queues have already set up their GC size classes, whose
+     * initial chunks are ordinary memory, and the main thread has entered
+     * the collector as node 0. Only refills from here on come from the
+     * huge page pools: the prefill's from node 0, and each worker's from
+     * its own node. */
+    gc_set_numa_pools(numa);
+    gc_set_trim_watermark((size_t)trim_mb << 20);
+    gc_set_backlog_limit(backlog);
+
+    if (count_misses && !CacheMisses().valid()) {
+        fprintf(stderr, "Could not open cache miss counter: %s\n", strerror(errno));
+        count_misses = false;
+    }
+
+    hwloc_topology_init(&topology);
+    hwloc_topology_load(topology);
+
+    server_args_t *ss = nullptr;
+
+    if (keys_str == nullptr || strcmp(keys_str, "uniform") == 0) {
+        key_pattern = KEYS_UNIFORM;
+    } else if (strcmp(keys_str, "monotone") == 0) {
+        key_pattern = KEYS_MONOTONE;
+    } else {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (bucket_shift < MIN_BUCKET_SHIFT || bucket_shift > 31) {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (threads_per_core < 1) {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (backoff_str == nullptr || strcmp(backoff_str, "none") == 0) {
+        backoff_set_policy(BACKOFF_NONE);
+    } else if (strcmp(backoff_str, "exponential") == 0) {
+        backoff_set_policy(BACKOFF_EXPONENTIAL);
+    } else if (strcmp(backoff_str, "adaptive") == 0) {
+        backoff_set_policy(BACKOFF_ADAPTIVE);
+    } else {
+        usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (spray_str != nullptr) {
+        sl_spray_t spray = pq_spraylist.spray();
+        if (!parse_spray(spray_str, spray)) {
+            usage(stderr, argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        pq_spraylist.set_spray(spray);
+    }
+
     if (type_str == nullptr) {
         usage(stderr, argv[0]);
         exit(EXIT_FAILURE);
+    } else if (strcmp(type_str, "bucket") == 0) {
+        pq_bucket = new BucketQueue(std::numeric_limits<int>::max(), bucket_shift);
+        ins = [](const uint32_t v) { pq_bucket->insert(v); };
+        del = [](uint32_t &v) { return pq_bucket->delete_min(v); };
+        pq_init(*pq_bucket, init_size);
+    } else if (strcmp(type_str, "delegation") == 0) {
+        ins = [](const uint32_t v) { pq_delegation.insert(v); };
+        del = [](uint32_t &v) { return pq_delegation.delete_min(v); };
+
+        /* Servers must be up before the queue is initialized. */
+        ss = new server_args_t[nservers];
+        for (int i = 0; i < nservers; i++) {
+            ss[i].id = i;
+            ss[i].nservers = nservers;
+            ss[i].nthreads = nthreads;
+            pthread_create(&ss[i].thread, NULL, serve, &ss[i]);
+        }
+
+        pq_init(pq_delegation, init_size);
     } else if (strcmp(type_str, "globallock") == 0) {
         ins = [](const uint32_t v) { pq_globallock.insert(v); };
         del = [](uint32_t &v) { return pq_globallock.delete_min(v); };
@@ -170,25 +713,60 @@ main(int argc __attribute__ ((unused)),
         ins = [](const uint32_t v) { pq_heap.insert(v); };
         del = [](uint32_t &v) { return pq_heap.delete_min(v); };
         pq_init(pq_heap, init_size);
+    } else if (strcmp(type_str, "linden") == 0 && eliminate) {
+        ins = [](const uint32_t v) { pq_linden_elim.insert(v); };
+        del = [](uint32_t &v) { return pq_linden_elim.delete_min(v); };
+        print_stats = [](FILE *out) { print_elimination_stats(out, pq_linden_elim); };
+        pq_init(pq_linden_elim, init_size);
     } else if (strcmp(type_str, "linden") == 0) {
         ins = [](const uint32_t v) { pq_linden.insert(v); };
         del = [](uint32_t &v) { return pq_linden.delete_min(v); };
+        pq_selected.ins_sorted = [](const uint32_t *vs, const size_t n) {
+            pq_linden.insert_sorted(vs, n);
+        };
         pq_init(pq_linden, init_size);
+    } else if (strcmp(type_str, "mound") == 0) {
+        ins = [](const uint32_t v) { pq_mound.insert(v); };
+        del = [](uint32_t &v) { return pq_mound.delete_min(v); };
+        pq_init(pq_mound, init_size);
     } else if (strcmp(type_str, "noble") == 0) {
         ins = [](const uint32_t v) { pq_noble.insert(v); };
         del = [](uint32_t &v) { return pq_noble.delete_min(v); };
         pq_init(pq_noble, init_size);
+    } else if (strcmp(type_str, "spraylist") == 0 && eliminate) {
+        ins = [](const uint32_t v) { pq_spraylist_elim.insert(v); };
+        del = [](uint32_t &v) { return pq_spraylist_elim.delete_min(v); };
+        print_stats = [](FILE *out) {
+            print_elimination_stats(out, pq_spraylist_elim);
+            print_spray_stats(out);
+        };
+        pq_init(pq_spraylist_elim, init_size);
     } else if (strcmp(type_str, "spraylist") == 0) {
         ins = [](const uint32_t v) { pq_spraylist.insert(v); };
         del = [](uint32_t &v) { return pq_spraylist.delete_min(v); };
+        print_stats = print_spray_stats;
         pq_init(pq_spraylist, init_size);
     } else {
         usage(stderr, argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    hwloc_topology_init(&topology);
-    hwloc_topology_load(topology);
+    const size_t prefill_rss = rss_bytes();
+
+    /* Wrap the prefilled queue. */
+    if (buffer > 0) {
+        pq_selected.ins = ins;
+        pq_selected.del = del;
+        /* Plain new does not honor the cache line alignment of the buffer. */
+        void *mem;
+        if (posix_memalign(&mem, CACHE_LINE_SIZE, sizeof(Buffered<selected_pq>)) != 0) {
+            abort();
+        }
+        pq_buffered = new (mem) Buffered<selected_pq>(pq_selected, buffer);
+
+        ins = [](const uint32_t v) { pq_buffered->insert(v); };
+        del = [](uint32_t &v) { return pq_buffered->delete_min(v); };
+    }
 
     thread_args_t *ts = new thread_args_t[nthreads];
     memset(ts, 0, nthreads * sizeof(thread_args_t));
@@ -206,9 +784,24 @@ main(int argc __attribute__ ((unused)),
 
     struct timespec start, end;
 
+    const bool sample_offset = adaptive && verbose &&
+        (strcmp(type_str, "linden") == 0);
+    const bool uses_gc = (strcmp(type_str, "linden") == 0 &&
+                          reclamation == Linden::RECLAIM_EPOCH) ||
+        (strcmp(type_str, "mound") == 0) ||
+        (strcmp(type_str, "bucket") == 0) ||
+        (strcmp(type_str, "spraylist") == 0);
+
     loop.store(true);
     gettime(&start);
-    usleep(1000000 * secs);
+    if (sample_offset) {
+        for (int ms = 0; ms < 1000 * secs; ms += OFFSET_SAMPLE_MS) {
+            usleep(1000 * OFFSET_SAMPLE_MS);
+            printf("Offset:\t\t%d ms\t%d\n", ms + OFFSET_SAMPLE_MS, pq_linden.max_offset());
+        }
+    } else {
+        usleep(1000000 * secs);
+    }
     loop.store(false);
     gettime(&end);
 
@@ -216,6 +809,14 @@ main(int argc __attribute__ ((unused)),
         pthread_join(t->thread, NULL);
     }
 
+    if (ss != nullptr) {
+        pq_delegation.stop();
+        for (int i = 0; i < nservers; i++) {
+            pthread_join(ss[i].thread, NULL);
+        }
+        delete[] ss;
+    }
+
     /* PRINT PERF. MEASURES */
     int sum = 0, min = std::numeric_limits<int>::max(), max = 0;
 
@@ -233,12 +834,44 @@ main(int argc __attribute__ ((unused)),
         printf("Ops/s:\t\t%.0f\n", (double) sum / dt);
         printf("Min ops/t:\t%d\n", min);
         printf("Max ops/t:\t%d\n", max);
+        printf(TIMESTAMP_UNIT "/insert:\t%.0f (prefill)\n",
+               init_size == 0 ? 0.0 : (double) init_cycles / init_size);
+        printf("RSS:\t\t%zu KiB (%zu KiB after prefill)\n",
+               rss_bytes() >> 10, prefill_rss >> 10);
+
+        if (print_stats != nullptr) {
+            print_stats(stdout);
+        }
+
+        if (uses_gc) {
+            print_gc_stats(stdout);
+        }
+
+        if (use_michael) {
+            print_michael_stats(stdout);
+        }
+
+        if (count_misses) {
+            printf("Misses/insert:\t%.2f (prefill)\n",
+                   init_size == 0 ? 0.0 : (double) init_misses / init_size);
+            const uint64_t inserts = run_inserts.load();
+            const uint64_t deletes = run_deletes.load();
+            printf("Misses/insert:\t%.2f\n",
+                   inserts == 0 ? 0.0 : (double) run_ins_misses.load() / inserts);
+            printf("Misses/delete:\t%.2f\n",
+                   deletes == 0 ? 0.0 : (double) run_del_misses.load() / deletes);
+        }
     } else {
         printf("%.0f\n", (double) sum / dt);
     }
 
     hwloc_topology_destroy(topology);
     delete[] ts;
+    delete pq_bucket;
+    if (pq_buffered != nullptr) {
+        pq_buffered->~Buffered<selected_pq>();
+        free(pq_buffered);
+    }
 
     return 0;
 }
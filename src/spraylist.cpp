@@ -1,12 +1,16 @@
 #include "spraylist.h"
 
+#include <mutex>
+#include <vector>
+
 extern "C" {
 #include "spraylist/include/random.h"
 #include "spraylist/intset.h"
 #include "spraylist/linden.h"
 }
 
-constexpr unsigned int INITIAL_SIZE = 1 << 15;
+/** Sets the initial height, the list grows with its size from there. */
+constexpr unsigned int INITIAL_SIZE = 1 << 10;
 
 /** See documentation of --elasticity in spraylist/test.c. */
 #define READ_ADD_REM_ELASTIC_TX (4)
@@ -14,6 +18,33 @@ constexpr unsigned int INITIAL_SIZE = 1 << 15;
 static __thread bool initialized = false;
 static __thread thread_data_t *d;
 
+/** Removes exiting threads from the live threads of the adaptive spray. */
+struct spray_exit_t {
+    ~spray_exit_t()
+    {
+        if (d != nullptr && d->spray_set != nullptr) {
+            spray_leave(d->spray_set, d);
+        }
+    }
+};
+static thread_local spray_exit_t spray_exit;
+
+/** Thread data of all threads, for statistics. The struct tag avoids the
+ * alignment attribute of the typedef, which a template argument drops. */
+static std::mutex &
+threads_mutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+static std::vector<struct thread_data *> &
+threads()
+{
+    static std::vector<struct thread_data *> ts;
+    return ts;
+}
+
 __thread unsigned long *seeds;
 
 
@@ -27,7 +58,12 @@ SprayList::SprayList()
 SprayList::~SprayList()
 {
     sl_set_delete(m_q);
-    delete d;
+
+    std::lock_guard<std::mutex> g(threads_mutex());
+    for (thread_data_t *t : threads()) {
+        delete t;
+    }
+    threads().clear();
 }
 
 void
@@ -38,16 +74,46 @@ SprayList::init_thread(const size_t nthreads)
 
         ssalloc_init();
 
-        d = new thread_data_t;
+        d = new thread_data_t();
         d->seed = rand();
         d->seed2 = rand();
+        /* Selects the lock-free paths of sl_add() and friends. */
+        d->unit_tx = READ_ADD_REM_ELASTIC_TX;
 
         initialized = true;
+        (void)&spray_exit; /* Constructs it, so that it is destroyed at exit. */
+
+        std::lock_guard<std::mutex> g(threads_mutex());
+        threads().push_back(d);
     }
 
     d->nb_threads = nthreads;
 }
 
+sl_spray_t
+SprayList::spray() const
+{
+    return m_q->spray;
+}
+
+void
+SprayList::set_spray(const sl_spray_t &spray)
+{
+    m_q->spray = spray;
+}
+
+void
+SprayList::retries(uint64_t counts[SL_SPRAY_RETRIES + 1]) const
+{
+    std::lock_guard<std::mutex> g(threads_mutex());
+    for (int i = 0; i <= SL_SPRAY_RETRIES; i++) {
+        counts[i] = 0;
+        for (const thread_data_t *t : threads()) {
+            counts[i] += t->spray_retries[i];
+        }
+    }
+}
+
 void
 SprayList::insert(const uint32_t v)
 {
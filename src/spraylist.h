@@ -13,6 +13,17 @@ public:
 
     void init_thread(const size_t nthreads);
 
+    /** Spray parameters, to be set before threads operate on the queue. */
+    sl_spray_t spray() const;
+    void set_spray(const sl_spray_t &spray);
+
+    /**
+     * Sums the deletes of all threads by the number of sprays which
+     * failed before they succeeded. The last entry counts deletes which
+     * fell back to a naive delete_min after SL_SPRAY_RETRIES failures.
+     */
+    void retries(uint64_t counts[SL_SPRAY_RETRIES + 1]) const;
+
     void insert(const uint32_t v);
     bool delete_min(uint32_t &v);
 